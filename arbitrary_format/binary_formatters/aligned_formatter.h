@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// aligned_formatter.h
+///
+/// This file contains aligned_formatter that stores zero padding up to a multiple of given alignment, before or after the value.
+/// NOTE: This formatter requires it's serializer to define position().
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_aligned_formatter_H
+#define ArbitraryFormatSerializer_aligned_formatter_H
+
+#include <arbitrary_format/binary_serializers/SerializerAlignment.h>
+
+#include <cstddef>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+/// @brief Where aligned_formatter puts its padding.
+enum class padding_placement
+{
+    before_value,   ///< The value starts at a multiple of the alignment.
+    after_value,    ///< Whatever follows the value starts at a multiple of the alignment.
+};
+
+/// @brief aligned_formatter stores the value, formatted with ValueFormatter, at a position that is a multiple of Align,
+///        or with padding after it, so that the data following it starts at such position.
+///        Padding consists of zero bytes, and is verified on load.
+///        To align elements of a vector use aligned_formatter<Align, SizeFormatter, padding_placement::after_value> as vector_formatter's size_formatter,
+///        i.e. vector_formatter< aligned_formatter<8, little_endian<4>, padding_placement::after_value>, little_endian<8> > for doubles.
+///        Such vectors can be loaded into boost::iterator_range<const T*> pointing directly to the source buffer.
+template<size_t Align, typename ValueFormatter, padding_placement Placement = padding_placement::before_value>
+class aligned_formatter
+{
+    static_assert(Align > 0, "Alignment must be greater than zero.");
+
+    ValueFormatter value_formatter;
+
+public:
+    aligned_formatter(ValueFormatter value_formatter = ValueFormatter())
+        : value_formatter(value_formatter)
+    {
+    }
+
+    template<typename ValueType, typename TSerializer>
+    void save(TSerializer& serializer, const ValueType& value) const
+    {
+        align_before(serializer);
+        value_formatter.save(serializer, value);
+        align_after(serializer);
+    }
+
+    template<typename ValueType, typename TSerializer>
+    void load(TSerializer& serializer, ValueType& value) const
+    {
+        align_before(serializer);
+        value_formatter.load(serializer, value);
+        align_after(serializer);
+    }
+
+private:
+    template<typename TSerializer>
+    static void align_before(TSerializer& serializer)
+    {
+        if (Placement == padding_placement::before_value)
+        {
+            align_serializer(serializer, Align);
+        }
+    }
+
+    template<typename TSerializer>
+    static void align_after(TSerializer& serializer)
+    {
+        if (Placement == padding_placement::after_value)
+        {
+            align_serializer(serializer, Align);
+        }
+    }
+};
+
+template<size_t Align, padding_placement Placement = padding_placement::before_value, typename ValueFormatter>
+aligned_formatter<Align, ValueFormatter, Placement> create_aligned_formatter(ValueFormatter value_formatter = ValueFormatter())
+{
+    return aligned_formatter<Align, ValueFormatter, Placement>(value_formatter);
+}
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_aligned_formatter_H
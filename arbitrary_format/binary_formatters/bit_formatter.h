@@ -15,6 +15,7 @@
 #define ArbitraryFormatSerializer_bit_formatter_H
 
 #include <arbitrary_format/binary_formatters/endian_formatter.h>
+#include <arbitrary_format/binary_formatters/fixed_size_of.h>
 #include <arbitrary_format/utility/bit_packer.h>
 
 namespace arbitrary_format
@@ -69,6 +70,10 @@ public:
     }
 };
 
+template<arbitrary_format_endian::order TargetOrder, int... Bits>
+struct fixed_size_of< bit_formatter<TargetOrder, Bits...> > : public std::integral_constant<size_t, sizeof(typename bit_packer<Bits...>::packed_type)>
+{};
+
 } // namespace binary
 } // namespace arbitrary_format
 
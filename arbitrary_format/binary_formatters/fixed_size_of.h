@@ -0,0 +1,86 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// fixed_size_of.h
+///
+/// This file contains fixed_size_of type trait, that gives number of bytes stored by formatters that always store the same number of bytes,
+/// and field_offset type trait, that gives offset of a field of a tuple_formatter made of such formatters.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_fixed_size_of_H
+#define ArbitraryFormatSerializer_fixed_size_of_H
+
+#include <arbitrary_format/binary_formatters/endian_formatter.h>
+#include <arbitrary_format/binary_formatters/verbatim_formatter.h>
+#include <arbitrary_format/formatters/array_formatter.h>
+#include <arbitrary_format/formatters/tuple_formatter.h>
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+/// @brief fixed_size_of is an integral_constant holding number of bytes stored by Formatter, for formatters that always store the same number of bytes.
+///        It's not defined for other formatters.
+///        Specialize it for other fixed size formatters.
+/// @note  Last type parameter is to allow for enable_if usage in specializations.
+template<typename Formatter, typename Enable = void>
+struct fixed_size_of;
+
+template<arbitrary_format_endian::order TargetOrder, int Size>
+struct fixed_size_of< endian_formatter<TargetOrder, Size> > : public std::integral_constant<size_t, Size>
+{};
+
+template<int Size>
+struct fixed_size_of< verbatim_formatter<Size> > : public std::integral_constant<size_t, Size>
+{};
+
+template<typename ValueFormatter, int ArraySize>
+struct fixed_size_of< array_formatter<ValueFormatter, ArraySize>, typename std::enable_if<(ArraySize >= 0)>::type > : public std::integral_constant<size_t, ArraySize * fixed_size_of<ValueFormatter>::value>
+{};
+
+template<size_t Idx>
+struct fixed_size_of< tuple_formatter_impl<Idx> > : public std::integral_constant<size_t, 0>
+{};
+
+template<size_t Idx, typename ValueFormatter, typename... ValueFormatters>
+struct fixed_size_of< tuple_formatter_impl<Idx, ValueFormatter, ValueFormatters...> > : public std::integral_constant<size_t, fixed_size_of<ValueFormatter>::value + fixed_size_of< tuple_formatter_impl<Idx + 1, ValueFormatters...> >::value>
+{};
+
+/// @brief record_field_formatter gives type of formatter of field I of a tuple_formatter.
+template<typename TupleFormatter, size_t I>
+struct record_field_formatter;
+
+template<size_t I, typename... ValueFormatters>
+struct record_field_formatter<tuple_formatter<ValueFormatters...>, I>
+{
+    static_assert(I < sizeof...(ValueFormatters), "Field index out of range.");
+    using type = typename std::tuple_element< I, std::tuple<ValueFormatters...> >::type;
+};
+
+/// @brief field_offset is an integral_constant holding offset of field I of a tuple_formatter of fixed size formatters.
+template<typename TupleFormatter, size_t I>
+struct field_offset;
+
+template<typename... ValueFormatters>
+struct field_offset<tuple_formatter<ValueFormatters...>, 0> : public std::integral_constant<size_t, 0>
+{};
+
+template<size_t I, typename... ValueFormatters>
+struct field_offset<tuple_formatter<ValueFormatters...>, I> : public std::integral_constant<size_t,
+    field_offset<tuple_formatter<ValueFormatters...>, I - 1>::value + fixed_size_of<typename record_field_formatter<tuple_formatter<ValueFormatters...>, I - 1>::type>::value>
+{};
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_fixed_size_of_H
@@ -0,0 +1,303 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// half_float_formatter.h
+///
+/// This file contains half_float_formatter and bfloat16_formatter that store floats on two bytes, as IEEE 754 half precision or bfloat16 numbers.
+/// Both are buffer formatters, so arrays and vectors of floats are converted in bulk - using F16C instructions, if they are available.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_half_float_formatter_H
+#define ArbitraryFormatSerializer_half_float_formatter_H
+
+#include <arbitrary_format/binary_formatters/endian_formatter.h>
+#include <arbitrary_format/formatters/serialize_buffer.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+namespace detail
+{
+
+inline uint32_t float_bits(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bits_float(uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/// @brief IEEE 754 binary16: 1 sign bit, 5 exponent bits, 10 mantissa bits.
+///        Floats are rounded to nearest, ties to even. Values too big for half precision become infinities, NaNs stay (quiet) NaNs.
+struct ieee_half
+{
+    static uint16_t encode(float value)
+    {
+        uint32_t bits = float_bits(value);
+        uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        bits &= 0x7FFFFFFF;
+
+        if (bits > 0x7F800000)
+        {
+            // NaN - keep the top of the payload and make it quiet
+            return static_cast<uint16_t>(sign | 0x7E00 | ((bits >> 13) & 0x3FF));
+        }
+
+        if (bits >= 0x47800000)
+        {
+            // infinity, or a value too big even after rounding
+            return static_cast<uint16_t>(sign | 0x7C00);
+        }
+
+        if (bits >= 0x38800000)
+        {
+            // normal half: rebias exponent from 127 to 15 and round away 13 mantissa bits
+            uint32_t half = (bits >> 13) - ((127 - 15) << 10);
+            uint32_t rest = bits & 0x1FFF;
+            if ((rest > 0x1000) || ((rest == 0x1000) && (half & 1)))
+            {
+                ++half;     // carry into exponent is fine, it may produce an infinity
+            }
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        if (bits < 0x33000000)
+        {
+            // less than half of the smallest subnormal half
+            return sign;
+        }
+
+        // subnormal half: value / 2^-24, rounded
+        uint32_t mantissa = (bits & 0x7FFFFF) | 0x800000;
+        int shift = 126 - static_cast<int>(bits >> 23);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if ((rest > halfway) || ((rest == halfway) && (half & 1)))
+        {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    static float decode(uint16_t half)
+    {
+        uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+        uint32_t exponent = (half >> 10) & 0x1F;
+        uint32_t mantissa = half & 0x3FF;
+
+        if (exponent == 0x1F)
+        {
+            // infinity, or NaN made quiet
+            return bits_float(sign | 0x7F800000 | (mantissa != 0 ? 0x400000 : 0) | (mantissa << 13));
+        }
+
+        if (exponent != 0)
+        {
+            return bits_float(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+        }
+
+        if (mantissa == 0)
+        {
+            return bits_float(sign);
+        }
+
+        // subnormal half is a normal float
+        exponent = 127 - 14;
+        while ((mantissa & 0x400) == 0)
+        {
+            mantissa <<= 1;
+            --exponent;
+        }
+        return bits_float(sign | (exponent << 23) | ((mantissa & 0x3FF) << 13));
+    }
+
+    static void encode(const float* values, uint16_t* halves, size_t count)
+    {
+        size_t i = 0;
+#if defined(__F16C__)
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i converted = _mm256_cvtps_ph(_mm256_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(halves + i), converted);
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            halves[i] = encode(values[i]);
+        }
+    }
+
+    static void decode(const uint16_t* halves, float* values, size_t count)
+    {
+        size_t i = 0;
+#if defined(__F16C__)
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 converted = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(halves + i)));
+            _mm256_storeu_ps(values + i, converted);
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            values[i] = decode(halves[i]);
+        }
+    }
+};
+
+/// @brief bfloat16: upper 16 bits of a float - 1 sign bit, 8 exponent bits, 7 mantissa bits.
+///        Floats are rounded to nearest, ties to even. NaNs stay (quiet) NaNs.
+struct bfloat16
+{
+    static uint16_t encode(float value)
+    {
+        uint32_t bits = float_bits(value);
+        if ((bits & 0x7FFFFFFF) > 0x7F800000)
+        {
+            return static_cast<uint16_t>((bits >> 16) | 0x40);
+        }
+
+        bits += 0x7FFF + ((bits >> 16) & 1);
+        return static_cast<uint16_t>(bits >> 16);
+    }
+
+    static float decode(uint16_t half)
+    {
+        return bits_float(static_cast<uint32_t>(half) << 16);
+    }
+
+    /// @note There are no dedicated instructions for bfloat16 that we could rely on. This loop is simple enough for the compiler to vectorize.
+    static void encode(const float* values, uint16_t* halves, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            halves[i] = encode(values[i]);
+        }
+    }
+
+    static void decode(const uint16_t* halves, float* values, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = decode(halves[i]);
+        }
+    }
+};
+
+} // namespace detail
+
+/// @brief float16_formatter stores floats on two bytes in TargetOrder byte order, using given Encoding.
+///        Use half_float_formatter or bfloat16_formatter instead of using it directly.
+/// @note  Storing floats this way is lossy by design: no lossy_conversion is thrown.
+template<typename Encoding, arbitrary_format_endian::order TargetOrder>
+class float16_formatter
+{
+public:
+    template<typename TSerializer>
+    void save(TSerializer& serializer, float value) const
+    {
+        uint16_t encoded = Encoding::encode(value);
+        save_encoded(serializer, &encoded, 1);
+    }
+
+    template<typename TSerializer>
+    void load(TSerializer& serializer, float& value) const
+    {
+        uint16_t encoded;
+        load_encoded(serializer, &encoded, 1);
+        value = Encoding::decode(encoded);
+    }
+
+    /// @brief Converts and saves floats in chunks. Used by save_buffer().
+    template<typename TSerializer, typename SizeType>
+    void save_buffer(TSerializer& serializer, SizeType size, const float* array) const
+    {
+        uint16_t buffer[chunk_size];
+        for (size_t done = 0; done < static_cast<size_t>(size); done += chunk_size)
+        {
+            size_t count = std::min<size_t>(chunk_size, static_cast<size_t>(size) - done);
+            Encoding::encode(array + done, buffer, count);
+            save_encoded(serializer, buffer, count);
+        }
+    }
+
+    /// @brief Loads and converts floats in chunks. Used by load_buffer().
+    template<typename TSerializer, typename SizeType>
+    void load_buffer(TSerializer& serializer, SizeType size, float* array) const
+    {
+        uint16_t buffer[chunk_size];
+        for (size_t done = 0; done < static_cast<size_t>(size); done += chunk_size)
+        {
+            size_t count = std::min<size_t>(chunk_size, static_cast<size_t>(size) - done);
+            load_encoded(serializer, buffer, count);
+            Encoding::decode(buffer, array + done, count);
+        }
+    }
+
+private:
+    static const size_t chunk_size = 256;
+
+    template<typename TSerializer>
+    static void save_encoded(TSerializer& serializer, uint16_t* encoded, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            encoded[i] = arbitrary_format_endian::conditional_reverse<arbitrary_format_endian::order::native, TargetOrder>(encoded[i]);
+        }
+        serializer.saveData(reinterpret_cast<const uint8_t*>(encoded), count * sizeof(uint16_t));
+    }
+
+    template<typename TSerializer>
+    static void load_encoded(TSerializer& serializer, uint16_t* encoded, size_t count)
+    {
+        serializer.loadData(reinterpret_cast<uint8_t*>(encoded), count * sizeof(uint16_t));
+        for (size_t i = 0; i < count; ++i)
+        {
+            encoded[i] = arbitrary_format_endian::conditional_reverse<TargetOrder, arbitrary_format_endian::order::native>(encoded[i]);
+        }
+    }
+};
+
+template<typename Encoding, arbitrary_format_endian::order TargetOrder>
+const size_t float16_formatter<Encoding, TargetOrder>::chunk_size;
+
+template<arbitrary_format_endian::order TargetOrder = arbitrary_format_endian::order::little>
+using half_float_formatter = float16_formatter<detail::ieee_half, TargetOrder>;
+
+template<arbitrary_format_endian::order TargetOrder = arbitrary_format_endian::order::little>
+using bfloat16_formatter = float16_formatter<detail::bfloat16, TargetOrder>;
+
+} // namespace binary
+
+/// @brief float16_formatter converts whole buffers of floats at once.
+template<typename Encoding, arbitrary_format_endian::order TargetOrder>
+struct declare_buffer_formatter< binary::float16_formatter<Encoding, TargetOrder>, float > : public std::true_type
+{};
+
+static_assert(is_buffer_formatter< binary::half_float_formatter<>, float >::value, "half_float_formatter should be a buffer formatter for floats.");
+static_assert(!is_buffer_formatter< binary::half_float_formatter<>, double >::value, "half_float_formatter should not be a buffer formatter for doubles.");
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_half_float_formatter_H
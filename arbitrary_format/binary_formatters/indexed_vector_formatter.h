@@ -0,0 +1,296 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// indexed_vector_formatter.h
+///
+/// This file contains indexed_vector_formatter that formats vectors of variable-size elements as size, followed by a table of offsets,
+/// followed by the elements. Element i can be read with indexed_vector_reader, without decoding elements before it.
+/// NOTE: indexed_vector_reader requires it's serializer to be ISeekable.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_indexed_vector_formatter_H
+#define ArbitraryFormatSerializer_indexed_vector_formatter_H
+
+#include <arbitrary_format/binary_formatters/size_prefix_formatter.h>
+#include <arbitrary_format/binary_serializers/LimitedSerializer.h>
+#include <arbitrary_format/binary_serializers/VectorSaveSerializer.h>
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+/// @brief Encoding of the offset table of indexed_vector_formatter.
+enum class offset_encoding
+{
+    absolute,   ///< Table holds end offset of every element, relative to the first element. Offsets must be stored on a fixed number of bytes, so that offset of element i can be found without reading the table.
+    delta,      ///< Table holds size of every element. Use with varint_formatter for a compact table. Table is read whole when indexed_vector_reader is created.
+};
+
+namespace detail
+{
+
+template<typename TSerializer>
+using serializer_position_t = typename std::decay<decltype(std::declval<TSerializer&>().position())>::type;
+
+/// @brief Loads one element of given byte count, verifying that it consumed exactly byteCount bytes.
+template<typename ValueFormatter, typename ValueType, typename TSerializer>
+void load_indexed_element(TSerializer& serializer, const ValueFormatter& value_formatter, size_t byteCount, ValueType& value)
+{
+    load_limited(serializer, byteCount, sized_formatter(value_formatter, byteCount), value);
+}
+
+} // namespace detail
+
+/// @brief indexed_vector_reader gives random access to elements of a vector stored with indexed_vector_formatter.
+///        It's created by indexed_vector_formatter::open(), that leaves the serializer after the end of the vector.
+///        Loading an element seeks to it, and back to the end of the vector afterwards.
+///        Serializers used with this class must define position() and seek() methods.
+template<typename TSerializer, typename OffsetFormatter, typename ValueFormatter, offset_encoding Encoding>
+class indexed_vector_reader
+{
+    using position_type = detail::serializer_position_t<TSerializer>;
+
+    TSerializer& serializer;
+    OffsetFormatter offset_formatter;
+    ValueFormatter value_formatter;
+    size_t element_count;
+    position_type table_position;
+    size_t offset_size;
+    position_type data_position;
+    size_t data_size;
+    std::vector<size_t> element_ends;   ///< @note Filled only for offset_encoding::delta.
+
+public:
+    /// @brief Reads the offset table (or its last entry), and moves the serializer after the end of the vector.
+    ///        Throws invalid_data if offsets are not ascending.
+    indexed_vector_reader(TSerializer& serializer, size_t element_count, OffsetFormatter offset_formatter, ValueFormatter value_formatter)
+        : serializer(serializer)
+        , offset_formatter(offset_formatter)
+        , value_formatter(value_formatter)
+        , element_count(element_count)
+        , table_position(serializer.position())
+        , offset_size(0)
+        , data_position(table_position)
+        , data_size(0)
+    {
+        read_table(std::integral_constant<offset_encoding, Encoding>());
+        serializer.seek(data_position + data_size);
+    }
+
+    size_t size() const
+    {
+        return element_count;
+    }
+
+    /// @brief Returns number of bytes taken by element of given index.
+    size_t element_size(size_t index)
+    {
+        auto range = element_range(index);
+        return range.second - range.first;
+    }
+
+    /// @brief Loads element of given index. Other elements are not read.
+    template<typename ValueType>
+    void load(size_t index, ValueType& value)
+    {
+        auto range = element_range(index);
+        serializer.seek(data_position + range.first);
+        detail::load_indexed_element(serializer, value_formatter, range.second - range.first, value);
+        serializer.seek(data_position + data_size);
+    }
+
+    template<typename ValueType>
+    ValueType get(size_t index)
+    {
+        ValueType value = ValueType();
+        load(index, value);
+        return value;
+    }
+
+private:
+    void read_table(std::integral_constant<offset_encoding, offset_encoding::absolute>)
+    {
+        if (element_count == 0)
+        {
+            return;
+        }
+
+        size_t firstEnd;
+        offset_formatter.load(serializer, firstEnd);
+        offset_size = static_cast<size_t>(serializer.position() - table_position);
+        if (offset_size == 0)
+        {
+            BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("offset_formatter must store at least one byte."));
+        }
+
+        data_position = table_position + element_count * offset_size;
+        data_size = read_end(element_count - 1);
+    }
+
+    void read_table(std::integral_constant<offset_encoding, offset_encoding::delta>)
+    {
+        size_t end = 0;
+        for (size_t i = 0; i < element_count; ++i)
+        {
+            size_t elementSize;
+            offset_formatter.load(serializer, elementSize);
+            if (end + elementSize < end)
+            {
+                BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Element sizes overflow."));
+            }
+            end += elementSize;
+            element_ends.push_back(end);
+        }
+
+        data_position = serializer.position();
+        data_size = end;
+    }
+
+    size_t read_end(size_t index)
+    {
+        if (Encoding == offset_encoding::delta)
+        {
+            return element_ends[index];
+        }
+
+        serializer.seek(table_position + index * offset_size);
+        size_t end;
+        offset_formatter.load(serializer, end);
+        return end;
+    }
+
+    /// @brief Returns begin and end offsets of given element.
+    std::pair<size_t, size_t> element_range(size_t index)
+    {
+        if (index >= element_count)
+        {
+            BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("Element index out of range."));
+        }
+
+        size_t begin = (index == 0) ? 0 : read_end(index - 1);
+        size_t end = read_end(index);
+        if ((begin > end) || (end > data_size))
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Element offsets are not ascending."));
+        }
+        return std::make_pair(begin, end);
+    }
+};
+
+/// @brief indexed_vector_formatter stores a vector as its size, formatted with SizeFormatter, followed by a table of offsets, formatted with OffsetFormatter,
+///        followed by the elements, formatted with ValueFormatter. See offset_encoding for the meaning of offsets.
+///        Elements are serialized to a temporary buffer first, so saving doesn't require a seekable serializer.
+///        ValueFormatters used with this formatter must have proper sized_formatter overload provided.
+template<typename SizeFormatter, typename OffsetFormatter, typename ValueFormatter, offset_encoding Encoding = offset_encoding::absolute>
+class indexed_vector_formatter
+{
+    SizeFormatter size_formatter;
+    OffsetFormatter offset_formatter;
+    ValueFormatter value_formatter;
+
+public:
+    /// @note With offset_encoding::absolute offset_formatter must always store the same number of bytes.
+    indexed_vector_formatter(SizeFormatter size_formatter = SizeFormatter(), OffsetFormatter offset_formatter = OffsetFormatter(), ValueFormatter value_formatter = ValueFormatter())
+        : size_formatter(size_formatter)
+        , offset_formatter(offset_formatter)
+        , value_formatter(value_formatter)
+    {
+    }
+
+    template<typename ValueType, typename Allocator, typename TSerializer>
+    void save(TSerializer& serializer, const std::vector<ValueType, Allocator>& vector) const
+    {
+        VectorSaveSerializer offsetSerializer;
+        VectorSaveSerializer elementSerializer;
+        size_t offsetSize = 0;
+        for (const auto& element : vector)
+        {
+            auto begin = elementSerializer.position();
+            value_formatter.save(elementSerializer, element);
+            auto end = elementSerializer.position();
+
+            auto offsetPosition = offsetSerializer.position();
+            offset_formatter.save(offsetSerializer, (Encoding == offset_encoding::absolute) ? end : end - begin);
+            if (Encoding == offset_encoding::absolute)
+            {
+                auto currentOffsetSize = offsetSerializer.position() - offsetPosition;
+                if ((offsetSize != 0) && (currentOffsetSize != offsetSize))
+                {
+                    BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("offset_formatter must always store the same number of bytes."));
+                }
+                offsetSize = currentOffsetSize;
+            }
+        }
+
+        size_formatter.save(serializer, vector.size());
+        serializer.saveData(offsetSerializer.getData().data(), offsetSerializer.getData().size());
+        serializer.saveData(elementSerializer.getData().data(), elementSerializer.getData().size());
+    }
+
+    /// @brief Loads all elements. Every element must consume exactly the number of bytes given by the offset table.
+    ///        Throws invalid_data if offsets are not ascending.
+    template<typename ValueType, typename Allocator, typename TSerializer>
+    void load(TSerializer& serializer, std::vector<ValueType, Allocator>& vector) const
+    {
+        size_t vectorSize;
+        size_formatter.load(serializer, vectorSize);
+
+        std::vector<size_t> elementSizes;
+        size_t previousEnd = 0;
+        for (size_t i = 0; i < vectorSize; ++i)
+        {
+            size_t offset;
+            offset_formatter.load(serializer, offset);
+            if (Encoding == offset_encoding::delta)
+            {
+                elementSizes.push_back(offset);
+                continue;
+            }
+            if (offset < previousEnd)
+            {
+                BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Element offsets are not ascending."));
+            }
+            elementSizes.push_back(offset - previousEnd);
+            previousEnd = offset;
+        }
+
+        vector.resize(vectorSize);
+        for (size_t i = 0; i < vectorSize; ++i)
+        {
+            detail::load_indexed_element(serializer, value_formatter, elementSizes[i], vector[i]);
+        }
+    }
+
+    /// @brief Reads size and offset table of a vector, and returns a reader that loads its elements on demand.
+    template<typename TSerializer>
+    indexed_vector_reader<TSerializer, OffsetFormatter, ValueFormatter, Encoding> open(TSerializer& serializer) const
+    {
+        size_t vectorSize;
+        size_formatter.load(serializer, vectorSize);
+        return indexed_vector_reader<TSerializer, OffsetFormatter, ValueFormatter, Encoding>(serializer, vectorSize, offset_formatter, value_formatter);
+    }
+};
+
+/// @brief Use create_indexed_vector_formatter<offset_encoding::delta>(...) for a table of element sizes.
+template<offset_encoding Encoding = offset_encoding::absolute, typename SizeFormatter, typename OffsetFormatter, typename ValueFormatter>
+indexed_vector_formatter<SizeFormatter, OffsetFormatter, ValueFormatter, Encoding> create_indexed_vector_formatter(SizeFormatter size_formatter = SizeFormatter(), OffsetFormatter offset_formatter = OffsetFormatter(), ValueFormatter value_formatter = ValueFormatter())
+{
+    return indexed_vector_formatter<SizeFormatter, OffsetFormatter, ValueFormatter, Encoding>(size_formatter, offset_formatter, value_formatter);
+}
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_indexed_vector_formatter_H
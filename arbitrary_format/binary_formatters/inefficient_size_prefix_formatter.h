@@ -18,7 +18,7 @@
 #define ArbitraryFormatSerializer_inefficient_size_prefix_formatter_H
 
 #include <arbitrary_format/binary_serializers/SizeCountingSerializer.h>
-#include <arbitrary_format/binary_serializers/ScopedSerializer.h>
+#include <arbitrary_format/binary_serializers/LimitedSerializer.h>
 
 namespace arbitrary_format
 {
@@ -58,9 +58,7 @@ public:
         uintmax_t byteCount;
         size_formatter.load(serializer, byteCount);
 
-        ScopedSerializer<TSerializer> scopedSerializer(serializer, byteCount);
-        value_formatter.load(scopedSerializer, value);
-        scopedSerializer.verifyAllBytesProcessed();
+        load_limited(serializer, byteCount, value_formatter, value);
     }
 };
 
@@ -0,0 +1,216 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// interned_string_formatter.h
+///
+/// This file contains interned_string_formatter that stores every distinct string only once, and further occurrences as indices.
+/// Strings are kept in a string_interning_context, that must be shared by all formatters of one save or load session.
+/// Use one context per message, or one per stream to share the dictionary between messages.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_interned_string_formatter_H
+#define ArbitraryFormatSerializer_interned_string_formatter_H
+
+#include <arbitrary_format/binary_formatters/string_formatter.h>
+#include <arbitrary_format/binary_formatters/varint_formatter.h>
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+/// @brief Dictionary of strings already saved or loaded by interned_string_formatter.
+///        Strings get consecutive indices starting from 1, in order of their first occurrence.
+///        Loaded strings are kept in the context, and strings loaded as views point to them. Call clear() to start a new dictionary.
+class string_interning_context
+{
+public:
+    /// @brief Returns index of given string, and whether it was seen for the first time.
+    ///        Strings are looked up by view, so only a string seen for the first time is copied.
+    std::pair<size_t, bool> register_saved(boost::string_ref string)
+    {
+        auto found = saved_indices.find(string);
+        if (found != saved_indices.end())
+        {
+            return std::make_pair(found->second, false);
+        }
+
+        saved_strings.emplace_back(string.data(), string.size());
+        const std::string& stored = saved_strings.back();
+        saved_indices.emplace(boost::string_ref(stored.data(), stored.size()), saved_strings.size());
+        return std::make_pair(saved_strings.size(), true);
+    }
+
+    /// @brief Returns saved string of given index.
+    const std::string& get_saved(size_t index) const
+    {
+        return saved_strings[index - 1];
+    }
+
+    /// @brief Adds a string to the dictionary of loaded strings. Returns the stored string.
+    const std::string& register_loaded(std::string&& string)
+    {
+        loaded_strings.push_back(std::move(string));
+        return loaded_strings.back();
+    }
+
+    /// @brief Returns string of given index.
+    ///        Throws invalid_data if there is no such string.
+    const std::string& get_loaded(size_t index) const
+    {
+        if ((index == 0) || (index > loaded_strings.size()))
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Reference to a string that was not loaded yet."));
+        }
+        return loaded_strings[index - 1];
+    }
+
+    void clear()
+    {
+        saved_indices.clear();
+        saved_strings.clear();
+        loaded_strings.clear();
+    }
+
+private:
+    struct string_ref_hash
+    {
+        size_t operator()(boost::string_ref string) const
+        {
+            return boost::hash_range(string.begin(), string.end());
+        }
+    };
+
+    std::unordered_map<boost::string_ref, size_t, string_ref_hash> saved_indices;     ///< @note Keys point to saved_strings.
+    std::deque<std::string> saved_strings;      ///< @note Deque, so keys of saved_indices aren't invalidated when new strings are added.
+    std::deque<std::string> loaded_strings;     ///< @note Deque, so views of loaded strings aren't invalidated when new strings are added.
+};
+
+/// @brief interned_string_formatter stores a string as its index in the dictionary, formatted with IndexFormatter.
+///        First occurrence of a string is stored as index 0 followed by the string, formatted with StringFormatter.
+///        Strings can be loaded into std::string, or as boost::string_ref (or std::string_view) pointing to the context's copy of the string.
+template<typename IndexFormatter = varint_formatter, typename StringFormatter = string_formatter<varint_formatter>>
+class interned_string_formatter
+{
+    string_interning_context& context;
+    IndexFormatter index_formatter;
+    StringFormatter string_formatter;
+
+public:
+    explicit interned_string_formatter(string_interning_context& context, IndexFormatter index_formatter = IndexFormatter(), StringFormatter string_formatter = StringFormatter())
+        : context(context)
+        , index_formatter(index_formatter)
+        , string_formatter(string_formatter)
+    {
+    }
+
+    template<typename TSerializer>
+    void save(TSerializer& serializer, const std::string& string) const
+    {
+        save_interned(serializer, boost::string_ref(string.data(), string.size()));
+    }
+
+    template<typename TSerializer>
+    void save(TSerializer& serializer, const char* string) const
+    {
+        save_interned(serializer, boost::string_ref(string));
+    }
+
+    template<typename TSerializer>
+    void save(TSerializer& serializer, boost::string_ref string) const
+    {
+        save_interned(serializer, string);
+    }
+
+    template<typename TSerializer>
+    void load(TSerializer& serializer, std::string& string) const
+    {
+        string = load_interned(serializer);
+    }
+
+    /// @note Loaded view is valid as long as the context is alive and not cleared.
+    template<typename TSerializer>
+    void load(TSerializer& serializer, boost::string_ref& string) const
+    {
+        const std::string& interned = load_interned(serializer);
+        string = boost::string_ref(interned.data(), interned.size());
+    }
+
+#if __cplusplus >= 201703L
+    template<typename TSerializer>
+    void save(TSerializer& serializer, std::string_view string) const
+    {
+        save_interned(serializer, boost::string_ref(string.data(), string.size()));
+    }
+
+    /// @note Loaded view is valid as long as the context is alive and not cleared.
+    template<typename TSerializer>
+    void load(TSerializer& serializer, std::string_view& string) const
+    {
+        string = load_interned(serializer);
+    }
+#endif
+
+private:
+    /// @note Strings seen before are saved without allocating. New strings are saved from the context's copy.
+    template<typename TSerializer>
+    void save_interned(TSerializer& serializer, boost::string_ref string) const
+    {
+        auto index = context.register_saved(string);
+        if (index.second)
+        {
+            index_formatter.save(serializer, size_t(0));
+            string_formatter.save(serializer, context.get_saved(index.first));
+        }
+        else
+        {
+            index_formatter.save(serializer, index.first);
+        }
+    }
+
+    /// @note Throws invalid_data if loaded index is not an index of an already loaded string.
+    template<typename TSerializer>
+    const std::string& load_interned(TSerializer& serializer) const
+    {
+        size_t index;
+        index_formatter.load(serializer, index);
+        if (index != 0)
+        {
+            return context.get_loaded(index);
+        }
+
+        std::string string;
+        string_formatter.load(serializer, string);
+        return context.register_loaded(std::move(string));
+    }
+};
+
+template<typename IndexFormatter = varint_formatter, typename StringFormatter = string_formatter<varint_formatter>>
+interned_string_formatter<IndexFormatter, StringFormatter> create_interned_string_formatter(string_interning_context& context, IndexFormatter index_formatter = IndexFormatter(), StringFormatter string_formatter = StringFormatter())
+{
+    return interned_string_formatter<IndexFormatter, StringFormatter>(context, index_formatter, string_formatter);
+}
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_interned_string_formatter_H
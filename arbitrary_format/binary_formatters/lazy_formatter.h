@@ -0,0 +1,233 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// lazy_formatter.h
+///
+/// This file contains lazy_formatter that formats lazy<T> values as size of the serialized value followed by the value.
+/// When loading from a serializer that can return views of its data (like MemoryLoadSerializer) only the location of the value is recorded,
+/// and the value is decoded on first access.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_lazy_formatter_H
+#define ArbitraryFormatSerializer_lazy_formatter_H
+
+#include <arbitrary_format/binary_formatters/size_prefix_formatter.h>
+#include <arbitrary_format/binary_serializers/ISerializer.h>
+#include <arbitrary_format/binary_serializers/MemorySerializer.h>
+#include <arbitrary_format/binary_serializers/LimitedSerializer.h>
+#include <arbitrary_format/binary_serializers/VectorSaveSerializer.h>
+#include <arbitrary_format/serialization_exceptions.h>
+#include <arbitrary_format/utility/small_buffer_storage.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include <boost/optional.hpp>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+/// @brief lazy holds either a value of type T, or serialized data of the value, that will be decoded on first access.
+///        Serialized data is not copied: it must outlive the lazy object, or at least its first access.
+/// @note  Decoding is not thread safe, even through const methods.
+template<typename T>
+class lazy
+{
+    using decode_function = void (*)(const small_buffer_storage<>& formatter, const uint8_t* data, size_t size, T& value);
+
+    mutable boost::optional<T> value;
+    const uint8_t* data;
+    size_t size;
+    small_buffer_storage<> formatter;
+    decode_function decode;
+
+public:
+    lazy()
+        : data(nullptr)
+        , size(0)
+        , decode(nullptr)
+    {
+    }
+
+    lazy(T value)
+        : value(std::move(value))
+        , data(nullptr)
+        , size(0)
+        , decode(nullptr)
+    {
+    }
+
+    /// @brief Replaces the value with serialized data, that will be decoded with given formatter on first access.
+    template<typename Formatter>
+    void assign_encoded(const uint8_t* data, size_t size, const Formatter& formatter)
+    {
+        value = boost::none;
+        this->data = data;
+        this->size = size;
+        this->formatter.template emplace<Formatter>(formatter);
+        decode = &decode_with<Formatter>;
+    }
+
+    /// @brief Returns true if the value is available without decoding.
+    bool is_decoded() const
+    {
+        return !!value;
+    }
+
+    /// @brief Returns true if the value has serialized data, that is known to represent the value.
+    bool has_encoded() const
+    {
+        return decode != nullptr;
+    }
+
+    const uint8_t* encoded_data() const
+    {
+        return data;
+    }
+
+    size_t encoded_size() const
+    {
+        return size;
+    }
+
+    /// @brief Returns the value, decoding it if needed.
+    ///        Throws invalid_data (or other serialization exceptions) if the serialized data is broken.
+    const T& get() const
+    {
+        if (!value)
+        {
+            T decoded = T();
+            if (decode)
+            {
+                decode(formatter, data, size, decoded);
+            }
+            value = std::move(decoded);
+        }
+        return *value;
+    }
+
+    /// @brief Returns the value for modification. Serialized data is dropped, since it might no longer match the value.
+    T& get()
+    {
+        const lazy& self = *this;
+        self.get();
+        data = nullptr;
+        size = 0;
+        formatter.reset();
+        decode = nullptr;
+        return *value;
+    }
+
+    const T& operator*() const
+    {
+        return get();
+    }
+
+    T& operator*()
+    {
+        return get();
+    }
+
+    const T* operator->() const
+    {
+        return &get();
+    }
+
+    T* operator->()
+    {
+        return &get();
+    }
+
+private:
+    template<typename Formatter>
+    static void decode_with(const small_buffer_storage<>& formatter, const uint8_t* data, size_t size, T& value)
+    {
+        MemoryLoadSerializer serializer(data, size);
+        sized_formatter(formatter.template get<Formatter>(), size).load(serializer, value);
+        if (serializer.position() != size)
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_requested_this_many_bytes_more(size - serializer.position()));
+        }
+    }
+};
+
+/// @brief lazy_formatter stores lazy<T> as size of the serialized value, formatted with SizeFormatter, followed by the value, formatted with ValueFormatter.
+///        Values that were not decoded are saved as their original serialized data, without decoding.
+///        For values of fixed serialized size use ensure_value<size_t> as SizeFormatter, so that the size isn't stored at all.
+///        When loading from a serializer that has viewData() only the location of data is recorded, and the value is decoded on first access.
+///        With other serializers values are loaded eagerly.
+/// @note  ValueFormatter must be able to load from MemoryLoadSerializer, and must not depend on state that changes before the value is accessed.
+template<typename SizeFormatter, typename ValueFormatter>
+class lazy_formatter
+{
+    SizeFormatter size_formatter;
+    ValueFormatter value_formatter;
+
+public:
+    lazy_formatter(SizeFormatter size_formatter = SizeFormatter(), ValueFormatter value_formatter = ValueFormatter())
+        : size_formatter(size_formatter)
+        , value_formatter(value_formatter)
+    {
+    }
+
+    template<typename T, typename TSerializer>
+    void save(TSerializer& serializer, const lazy<T>& value) const
+    {
+        if (value.has_encoded())
+        {
+            size_formatter.save(serializer, value.encoded_size());
+            serializer.saveData(value.encoded_data(), value.encoded_size());
+            return;
+        }
+
+        VectorSaveSerializer valueSerializer;
+        value_formatter.save(valueSerializer, value.get());
+        const auto& data = valueSerializer.getData();
+        size_formatter.save(serializer, data.size());
+        serializer.saveData(data.data(), data.size());
+    }
+
+    template<typename T, typename TSerializer>
+    void load(TSerializer& serializer, lazy<T>& value) const
+    {
+        size_t byteCount;
+        size_formatter.load(serializer, byteCount);
+        load_value(serializer, value, byteCount, has_view_data<TSerializer>());
+    }
+
+private:
+    template<typename T, typename TSerializer>
+    void load_value(TSerializer& serializer, lazy<T>& value, size_t byteCount, std::true_type) const
+    {
+        const uint8_t* data = serializer.viewData(byteCount);
+        value.assign_encoded(data, byteCount, value_formatter);
+    }
+
+    template<typename T, typename TSerializer>
+    void load_value(TSerializer& serializer, lazy<T>& value, size_t byteCount, std::false_type) const
+    {
+        T loadedValue = T();
+        load_limited(serializer, byteCount, sized_formatter(value_formatter, byteCount), loadedValue);
+        value = lazy<T>(std::move(loadedValue));
+    }
+};
+
+template<typename SizeFormatter, typename ValueFormatter>
+lazy_formatter<SizeFormatter, ValueFormatter> create_lazy_formatter(SizeFormatter size_formatter = SizeFormatter(), ValueFormatter value_formatter = ValueFormatter())
+{
+    return lazy_formatter<SizeFormatter, ValueFormatter>(size_formatter, value_formatter);
+}
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_lazy_formatter_H
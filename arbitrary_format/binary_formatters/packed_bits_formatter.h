@@ -0,0 +1,265 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// packed_bits_formatter.h
+///
+/// This file contains packed_bits_formatter that formats std::vector<bool>, std::bitset and boost::dynamic_bitset as bits packed in bytes.
+/// Bit i is stored in byte i / 8, on bit i % 8 (least significant bit first). Unused bits of the last byte are zero.
+/// std::bitset and boost::dynamic_bitset are converted a 64 bit word at a time. std::vector<bool> doesn't give portable access to its words,
+/// so it's converted bit by bit.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_packed_bits_formatter_H
+#define ArbitraryFormatSerializer_packed_bits_formatter_H
+
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <boost/dynamic_bitset.hpp>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+namespace detail
+{
+
+/// @brief Converts bits to bytes and back one 64 bit word at a time.
+class packed_bits
+{
+public:
+    static size_t byte_count(size_t bit_count)
+    {
+        return (bit_count + 7) / 8;
+    }
+
+    /// @brief Saves bit_count bits. get_word(k) must return bits [64 * k, 64 * k + 64) with unused bits set to zero.
+    template<typename TSerializer, typename GetWord>
+    static void save(TSerializer& serializer, size_t bit_count, GetWord&& get_word)
+    {
+        uint8_t buffer[chunk_words * 8];
+        size_t bytes_left = byte_count(bit_count);
+        size_t word_index = 0;
+        while (bytes_left > 0)
+        {
+            size_t chunk_bytes = std::min(bytes_left, sizeof(buffer));
+            for (size_t i = 0; i < chunk_bytes; i += 8)
+            {
+                uint64_t word = get_word(word_index++);
+                for (size_t j = 0; j < 8; ++j)
+                {
+                    buffer[i + j] = static_cast<uint8_t>(word >> (8 * j));
+                }
+            }
+
+            serializer.saveData(buffer, chunk_bytes);
+            bytes_left -= chunk_bytes;
+        }
+    }
+
+    /// @brief Loads bit_count bits. set_word(k, word) receives bits [64 * k, 64 * k + 64).
+    ///        Throws invalid_data if unused bits of the last byte are not zero.
+    template<typename TSerializer, typename SetWord>
+    static void load(TSerializer& serializer, size_t bit_count, SetWord&& set_word)
+    {
+        uint8_t buffer[chunk_words * 8];
+        size_t bytes_left = byte_count(bit_count);
+        size_t word_index = 0;
+        while (bytes_left > 0)
+        {
+            size_t chunk_bytes = std::min(bytes_left, sizeof(buffer));
+            serializer.loadData(buffer, chunk_bytes);
+            for (size_t i = 0; i < chunk_bytes; i += 8)
+            {
+                uint64_t word = 0;
+                for (size_t j = 0; (j < 8) && (i + j < chunk_bytes); ++j)
+                {
+                    word |= static_cast<uint64_t>(buffer[i + j]) << (8 * j);
+                }
+
+                size_t bits_left = bit_count - 64 * word_index;
+                if ((bits_left < 64) && (word >> bits_left) != 0)
+                {
+                    BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Unused bits must be zero."));
+                }
+
+                set_word(word_index++, word);
+            }
+
+            bytes_left -= chunk_bytes;
+        }
+    }
+
+private:
+    static const size_t chunk_words = 32;
+};
+
+} // namespace detail
+
+/// @brief packed_bits_formatter stores bit containers on one bit per element.
+///        std::vector<bool> and boost::dynamic_bitset are stored as number of bits (SizeFormatter) followed by packed bits.
+///        std::bitset<N> is stored as packed bits only, since its size is known at compile time.
+template<typename SizeFormatter>
+class packed_bits_formatter
+{
+    SizeFormatter size_formatter;
+
+public:
+    explicit packed_bits_formatter(SizeFormatter size_formatter = SizeFormatter())
+        : size_formatter(size_formatter)
+    {
+    }
+
+    template<typename Allocator, typename TSerializer>
+    void save(TSerializer& serializer, const std::vector<bool, Allocator>& bits) const
+    {
+        size_formatter.save(serializer, bits.size());
+        save_indexed(serializer, bits.size(), bits);
+    }
+
+    template<typename Allocator, typename TSerializer>
+    void load(TSerializer& serializer, std::vector<bool, Allocator>& bits) const
+    {
+        size_t bit_count;
+        size_formatter.load(serializer, bit_count);
+
+        bits.assign(bit_count, false);
+        load_indexed(serializer, bit_count, bits);
+    }
+
+    /// @note std::bitset gives no access to its words: a bitset of up to 64 bits is converted with to_ullong() in one step,
+    ///       and a longer one bit by bit (still linear in N - shifting and masking the whole bitset for every word would be quadratic).
+    template<size_t N, typename TSerializer>
+    void save(TSerializer& serializer, const std::bitset<N>& bits) const
+    {
+        if (N <= 64)
+        {
+            detail::packed_bits::save(serializer, N, [&bits](size_t)
+            {
+                return static_cast<uint64_t>(bits.to_ullong());
+            });
+        }
+        else
+        {
+            save_indexed(serializer, N, bits);
+        }
+    }
+
+    template<size_t N, typename TSerializer>
+    void load(TSerializer& serializer, std::bitset<N>& bits) const
+    {
+        if (N <= 64)
+        {
+            detail::packed_bits::load(serializer, N, [&bits](size_t, uint64_t word)
+            {
+                bits = std::bitset<N>(static_cast<unsigned long long>(word));
+            });
+        }
+        else
+        {
+            bits.reset();
+            load_indexed(serializer, N, bits);
+        }
+    }
+
+    template<typename Block, typename Allocator, typename TSerializer>
+    void save(TSerializer& serializer, const boost::dynamic_bitset<Block, Allocator>& bits) const
+    {
+        static_assert(64 % std::numeric_limits<Block>::digits == 0, "Block size must be a divisor of 64 bits.");
+        const size_t blocks_per_word = 64 / std::numeric_limits<Block>::digits;
+
+        std::vector<Block> blocks(bits.num_blocks());
+        boost::to_block_range(bits, blocks.begin());
+
+        size_formatter.save(serializer, bits.size());
+        detail::packed_bits::save(serializer, bits.size(), [&blocks, blocks_per_word](size_t word_index)
+        {
+            uint64_t word = 0;
+            for (size_t j = 0; (j < blocks_per_word) && (word_index * blocks_per_word + j < blocks.size()); ++j)
+            {
+                word |= static_cast<uint64_t>(blocks[word_index * blocks_per_word + j]) << (j * std::numeric_limits<Block>::digits);
+            }
+            return word;
+        });
+    }
+
+    template<typename Block, typename Allocator, typename TSerializer>
+    void load(TSerializer& serializer, boost::dynamic_bitset<Block, Allocator>& bits) const
+    {
+        static_assert(64 % std::numeric_limits<Block>::digits == 0, "Block size must be a divisor of 64 bits.");
+        const size_t blocks_per_word = 64 / std::numeric_limits<Block>::digits;
+
+        size_t bit_count;
+        size_formatter.load(serializer, bit_count);
+
+        bits.clear();
+        bits.resize(bit_count);
+        std::vector<Block> blocks(bits.num_blocks());
+        detail::packed_bits::load(serializer, bit_count, [&blocks, blocks_per_word](size_t word_index, uint64_t word)
+        {
+            for (size_t j = 0; (j < blocks_per_word) && (word_index * blocks_per_word + j < blocks.size()); ++j)
+            {
+                blocks[word_index * blocks_per_word + j] = static_cast<Block>(word >> (j * std::numeric_limits<Block>::digits));
+            }
+        });
+        boost::from_block_range(blocks.begin(), blocks.end(), bits);
+    }
+
+private:
+    /// @brief Saves any container of bits that provides operator[], bit by bit.
+    template<typename TSerializer, typename Bits>
+    void save_indexed(TSerializer& serializer, size_t bit_count, const Bits& bits) const
+    {
+        detail::packed_bits::save(serializer, bit_count, [&bits, bit_count](size_t word_index)
+        {
+            size_t first_bit = 64 * word_index;
+            size_t last_bit = std::min(first_bit + 64, bit_count);
+            uint64_t word = 0;
+            for (size_t i = first_bit; i < last_bit; ++i)
+            {
+                word |= static_cast<uint64_t>(bits[i] ? 1 : 0) << (i - first_bit);
+            }
+            return word;
+        });
+    }
+
+    /// @brief Loads any container of bits that provides operator[], bit by bit. Only set bits are assigned, so bits must be cleared before.
+    template<typename TSerializer, typename Bits>
+    void load_indexed(TSerializer& serializer, size_t bit_count, Bits& bits) const
+    {
+        detail::packed_bits::load(serializer, bit_count, [&bits, bit_count](size_t word_index, uint64_t word)
+        {
+            size_t first_bit = 64 * word_index;
+            size_t last_bit = std::min(first_bit + 64, bit_count);
+            for (size_t i = first_bit; (i < last_bit) && (word != 0); ++i, word >>= 1)
+            {
+                if ((word & 1) != 0)
+                {
+                    bits[i] = true;
+                }
+            }
+        });
+    }
+};
+
+template<typename SizeFormatter>
+packed_bits_formatter<SizeFormatter> create_packed_bits_formatter(SizeFormatter size_formatter = SizeFormatter())
+{
+    return packed_bits_formatter<SizeFormatter>(size_formatter);
+}
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_packed_bits_formatter_H
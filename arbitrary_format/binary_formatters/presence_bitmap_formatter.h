@@ -0,0 +1,188 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// presence_bitmap_formatter.h
+///
+/// This file contains presence_bitmap_formatter that formats a tuple of boost::optional values as a bitmap of presence bits followed by present values.
+/// It replaces a tuple of optional_formatters, that would store a whole flag before every value.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_presence_bitmap_formatter_H
+#define ArbitraryFormatSerializer_presence_bitmap_formatter_H
+
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <array>
+#include <cstdint>
+#include <tuple>
+
+#include <boost/optional.hpp>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+namespace detail
+{
+
+template<size_t Idx, typename... ValueFormatters>
+class presence_bitmap_fields;
+
+template<size_t Idx>
+class presence_bitmap_fields<Idx>
+{
+public:
+    template<typename Tuple>
+    void fill_bitmap(uint8_t*, const Tuple&) const
+    {
+        // nothing to do
+    }
+
+    template<typename Tuple, typename TSerializer>
+    void save(TSerializer&, const uint8_t*, const Tuple&) const
+    {
+        // nothing to do
+    }
+
+    template<typename Tuple, typename TSerializer>
+    void load(TSerializer&, const uint8_t*, Tuple&) const
+    {
+        // nothing to do
+    }
+};
+
+template<size_t Idx, typename ValueFormatter, typename... ValueFormatters>
+class presence_bitmap_fields<Idx, ValueFormatter, ValueFormatters...>
+{
+    ValueFormatter value_formatter;
+    presence_bitmap_fields<Idx + 1, ValueFormatters...> tail_fields;
+
+    static const uint8_t bit_mask = static_cast<uint8_t>(1 << (Idx % 8));
+
+public:
+    presence_bitmap_fields() = default;
+
+    explicit presence_bitmap_fields(ValueFormatter value_formatter, ValueFormatters... value_formatters)
+        : value_formatter(value_formatter)
+        , tail_fields(value_formatters...)
+    {
+    }
+
+    template<typename Tuple>
+    void fill_bitmap(uint8_t* bitmap, const Tuple& tuple) const
+    {
+        if (std::get<Idx>(tuple))
+        {
+            bitmap[Idx / 8] |= bit_mask;
+        }
+        tail_fields.fill_bitmap(bitmap, tuple);
+    }
+
+    template<typename Tuple, typename TSerializer>
+    void save(TSerializer& serializer, const uint8_t* bitmap, const Tuple& tuple) const
+    {
+        if (bitmap[Idx / 8] & bit_mask)
+        {
+            value_formatter.save(serializer, *std::get<Idx>(tuple));
+        }
+        tail_fields.save(serializer, bitmap, tuple);
+    }
+
+    template<typename Tuple, typename TSerializer>
+    void load(TSerializer& serializer, const uint8_t* bitmap, Tuple& tuple) const
+    {
+        load_field(serializer, (bitmap[Idx / 8] & bit_mask) != 0, std::get<Idx>(tuple));
+        tail_fields.load(serializer, bitmap, tuple);
+    }
+
+private:
+    /// @note Present values are loaded into already existing values, if there are any.
+    template<typename ValueType, typename TSerializer>
+    void load_field(TSerializer& serializer, bool present, boost::optional<ValueType>& value) const
+    {
+        if (!present)
+        {
+            value.reset();
+            return;
+        }
+
+        if (!value)
+        {
+            value = ValueType();
+        }
+        value_formatter.load(serializer, *value);
+    }
+};
+
+} // namespace detail
+
+/// @brief presence_bitmap_formatter stores a tuple of boost::optionals as:
+///          - (number of values + 7) / 8 bytes of presence bits; bit i % 8 of byte i / 8 is set if value i is present,
+///          - present values, each formatted with its ValueFormatter.
+///        Unused bits of the last byte of the bitmap are zero.
+template<typename... ValueFormatters>
+class presence_bitmap_formatter
+{
+    static_assert(sizeof...(ValueFormatters) > 0, "presence_bitmap_formatter needs at least one value formatter.");
+    static const size_t bitmap_size = (sizeof...(ValueFormatters) + 7) / 8;
+
+    detail::presence_bitmap_fields<0, ValueFormatters...> fields;
+
+public:
+    presence_bitmap_formatter() = default;
+
+    explicit presence_bitmap_formatter(ValueFormatters... value_formatters)
+        : fields(value_formatters...)
+    {
+    }
+
+    template<typename Tuple, typename TSerializer>
+    void save(TSerializer& serializer, const Tuple& tuple) const
+    {
+        static_assert(std::tuple_size<Tuple>::value == sizeof...(ValueFormatters), "Number of formatters must match the number of tuple elements.");
+
+        std::array<uint8_t, bitmap_size> bitmap = {};
+        fields.fill_bitmap(bitmap.data(), tuple);
+        serializer.saveData(bitmap.data(), bitmap.size());
+        fields.save(serializer, bitmap.data(), tuple);
+    }
+
+    /// @brief Throws invalid_data if unused bits of the bitmap are not zero.
+    template<typename Tuple, typename TSerializer>
+    void load(TSerializer& serializer, Tuple& tuple) const
+    {
+        static_assert(std::tuple_size<Tuple>::value == sizeof...(ValueFormatters), "Number of formatters must match the number of tuple elements.");
+
+        std::array<uint8_t, bitmap_size> bitmap;
+        serializer.loadData(bitmap.data(), bitmap.size());
+        if ((sizeof...(ValueFormatters) % 8 != 0) && (bitmap[bitmap_size - 1] >> (sizeof...(ValueFormatters) % 8)) != 0)
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Unused presence bits must be zero."));
+        }
+        fields.load(serializer, bitmap.data(), tuple);
+    }
+
+    /// @note This overload is to support std::tie seamlessly, the same way as tuple_formatter does.
+    template<typename Tuple, typename TSerializer>
+    void load(TSerializer& serializer, const Tuple& tuple) const
+    {
+        load(serializer, const_cast<Tuple&>(tuple));
+    }
+};
+
+template<typename... ValueFormatters>
+presence_bitmap_formatter<ValueFormatters...> create_presence_bitmap_formatter(ValueFormatters... value_formatters)
+{
+    return presence_bitmap_formatter<ValueFormatters...>(value_formatters...);
+}
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_presence_bitmap_formatter_H
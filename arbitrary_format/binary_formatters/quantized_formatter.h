@@ -0,0 +1,278 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// quantized_formatter.h
+///
+/// This file contains quantized_formatter that stores floats and doubles as fixed-point numbers of given number of bits.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_quantized_formatter_H
+#define ArbitraryFormatSerializer_quantized_formatter_H
+
+#include <arbitrary_format/binary_formatters/endian_formatter.h>
+#include <arbitrary_format/formatters/serialize_buffer.h>
+#include <arbitrary_format/utility/integer_for_size.h>
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ratio>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+/// @brief quantized_formatter stores a floating point value as an unsigned Bits-bit integer q, such that value == q * Scale + Offset.
+///        Values are rounded to the nearest step. q is stored with IntFormatter.
+///        Throws lossy_conversion if value is NaN or doesn't fit in Bits bits after quantization, just like endian_formatter does for too big integers.
+///        Arrays and vectors of floats and doubles are quantized in chunks: range checks of a chunk are combined into one branch,
+///        and the integers are passed to save_buffer() at once (a single copy for verbatim IntFormatter).
+///        With SSE2 (and Bits <= 52) floats and doubles are quantized two at a time, rounded by adding 2^52 instead of calling std::nearbyint(),
+///        with the same result in the current rounding mode. Otherwise, and for the last odd value, the scalar loop is used.
+/// @note  quantize() and dequantize() can be used to pack quantized values with bit_formatter.
+template<int Bits, typename Scale, typename Offset = std::ratio<0>, typename IntFormatter = little_endian<(Bits + 7) / 8>>
+class quantized_formatter
+{
+    static_assert((Bits > 0) && (Bits <= 53), "Quantized values must have from 1 to 53 bits, so doubles can represent them exactly.");
+    static_assert(Scale::num > 0, "Scale must be positive.");
+
+    IntFormatter int_formatter;
+
+public:
+    using quantized_type = typename integer_for_size<false, (Bits + 7) / 8>::type;
+
+    explicit quantized_formatter(IntFormatter int_formatter = IntFormatter())
+        : int_formatter(int_formatter)
+    {
+    }
+
+    /// @brief Returns the nearest step of given value.
+    ///        Throws lossy_conversion if the value is NaN or out of range.
+    template<typename T>
+    static quantized_type quantize(T value)
+    {
+        static_assert(std::is_floating_point<T>::value, "quantized_formatter can store only floating point types.");
+
+        double steps = to_steps(value);
+        if (!in_range(steps))
+        {
+            BOOST_THROW_EXCEPTION(lossy_conversion() << errinfo_description("Value is out of range of quantized_formatter."));
+        }
+        return static_cast<quantized_type>(steps);
+    }
+
+    /// @brief Returns value of given step.
+    ///        Throws invalid_data if quantized value has more than Bits bits.
+    template<typename T>
+    static T dequantize(quantized_type quantized)
+    {
+        static_assert(std::is_floating_point<T>::value, "quantized_formatter can store only floating point types.");
+
+        if (quantized > max_quantized)
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Quantized value has too many bits."));
+        }
+        return from_steps<T>(quantized);
+    }
+
+    template<typename T, typename TSerializer>
+    typename std::enable_if< std::is_floating_point<T>::value >::type
+    save(TSerializer& serializer, const T& value) const
+    {
+        int_formatter.save(serializer, quantize(value));
+    }
+
+    template<typename T, typename TSerializer>
+    typename std::enable_if< std::is_floating_point<T>::value >::type
+    load(TSerializer& serializer, T& value) const
+    {
+        quantized_type quantized;
+        int_formatter.load(serializer, quantized);
+        value = dequantize<T>(quantized);
+    }
+
+    /// @brief Quantizes and saves values in chunks. Used by save_buffer().
+    template<typename T, typename TSerializer, typename SizeType>
+    void save_buffer(TSerializer& serializer, SizeType size, const T* array) const
+    {
+        quantized_type buffer[chunk_size];
+        for (size_t done = 0; done < static_cast<size_t>(size); done += chunk_size)
+        {
+            size_t count = std::min<size_t>(chunk_size, static_cast<size_t>(size) - done);
+
+            if (!quantize_chunk(array + done, buffer, count))
+            {
+                BOOST_THROW_EXCEPTION(lossy_conversion() << errinfo_description("Value is out of range of quantized_formatter."));
+            }
+
+            arbitrary_format::save_buffer(serializer, count, buffer, int_formatter);
+        }
+    }
+
+    /// @brief Loads and dequantizes values in chunks. Used by load_buffer().
+    template<typename T, typename TSerializer, typename SizeType>
+    void load_buffer(TSerializer& serializer, SizeType size, T* array) const
+    {
+        quantized_type buffer[chunk_size];
+        for (size_t done = 0; done < static_cast<size_t>(size); done += chunk_size)
+        {
+            size_t count = std::min<size_t>(chunk_size, static_cast<size_t>(size) - done);
+            arbitrary_format::load_buffer(serializer, count, buffer, int_formatter);
+
+            quantized_type max_loaded = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                max_loaded = std::max(max_loaded, buffer[i]);
+                array[done + i] = from_steps<T>(buffer[i]);
+            }
+
+            if (max_loaded > max_quantized)
+            {
+                BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Quantized value has too many bits."));
+            }
+        }
+    }
+
+private:
+    static const size_t chunk_size = 256;
+    static const quantized_type max_quantized = static_cast<quantized_type>((uint64_t(1) << Bits) - 1);
+
+    /// @brief Quantizes count values to buffer. Returns false if any of them was NaN or out of range.
+    template<typename T>
+    static bool quantize_chunk(const T* values, quantized_type* buffer, size_t count)
+    {
+        bool all_in_range = true;
+        size_t i = quantize_pairs(values, buffer, count, all_in_range);
+        for (; i < count; ++i)
+        {
+            double steps = to_steps(values[i]);
+            bool ok = in_range(steps);
+            all_in_range &= ok;
+            buffer[i] = static_cast<quantized_type>(ok ? steps : 0.0);
+        }
+        return all_in_range;
+    }
+
+    /// @brief Quantizes values two at a time, as long as there are pairs left. Returns number of values quantized.
+    ///        This one is used when there is no vectorized version: it quantizes nothing.
+    template<typename T>
+    static size_t quantize_pairs(const T*, quantized_type*, size_t, bool&)
+    {
+        return 0;
+    }
+
+#if defined(__SSE2__)
+    static size_t quantize_pairs(const double* values, quantized_type* buffer, size_t count, bool& all_in_range)
+    {
+        return quantize_pairs_sse2(values, buffer, count, all_in_range);
+    }
+
+    static size_t quantize_pairs(const float* values, quantized_type* buffer, size_t count, bool& all_in_range)
+    {
+        return quantize_pairs_sse2(values, buffer, count, all_in_range);
+    }
+
+    static __m128d load_two(const double* values)
+    {
+        return _mm_loadu_pd(values);
+    }
+
+    static __m128d load_two(const float* values)
+    {
+        return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(values))));
+    }
+
+    /// @note Steps in [-0.5, max_quantized + 0.5) round to [0, max_quantized] (max_quantized is odd, so its upper half-way point rounds up),
+    ///       so the range is checked before rounding. Rounding adds and subtracts 2^52, which leaves no fraction bits,
+    ///       and the integer is read from the low bits of the sum. Both need Bits <= 52.
+    template<typename T>
+    static size_t quantize_pairs_sse2(const T* values, quantized_type* buffer, size_t count, bool& all_in_range)
+    {
+        if (Bits > 52)
+        {
+            return 0;
+        }
+
+        const __m128d offset = _mm_set1_pd(static_cast<double>(Offset::num) / Offset::den);
+        const __m128d scale_den = _mm_set1_pd(static_cast<double>(Scale::den));
+        const __m128d scale_num = _mm_set1_pd(static_cast<double>(Scale::num));
+        const __m128d lowest = _mm_set1_pd(-0.5);
+        const __m128d highest = _mm_set1_pd(static_cast<double>(max_quantized) + 0.5);
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d max_steps = _mm_set1_pd(static_cast<double>(max_quantized));
+        const __m128d magic = _mm_set1_pd(4503599627370496.0);    // 2^52
+
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            __m128d steps = _mm_div_pd(_mm_mul_pd(_mm_sub_pd(load_two(values + i), offset), scale_den), scale_num);
+            __m128d ok = _mm_and_pd(_mm_cmpge_pd(steps, lowest), _mm_cmplt_pd(steps, highest));
+            all_in_range &= (_mm_movemask_pd(ok) == 3);
+
+            // NaN is clamped to 0: max and min return their second operand then
+            __m128d rounded = _mm_add_pd(_mm_min_pd(_mm_max_pd(steps, zero), max_steps), magic);
+            uint64_t quantized[2];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(quantized), _mm_sub_epi64(_mm_castpd_si128(rounded), _mm_castpd_si128(magic)));
+            buffer[i] = static_cast<quantized_type>(quantized[0]);
+            buffer[i + 1] = static_cast<quantized_type>(quantized[1]);
+        }
+        return i;
+    }
+#endif
+
+    template<typename T>
+    static double to_steps(T value)
+    {
+        return std::nearbyint((static_cast<double>(value) - static_cast<double>(Offset::num) / Offset::den) * Scale::den / Scale::num);
+    }
+
+    template<typename T>
+    static T from_steps(quantized_type quantized)
+    {
+        return static_cast<T>(static_cast<double>(quantized) * Scale::num / Scale::den + static_cast<double>(Offset::num) / Offset::den);
+    }
+
+    /// @note NaN fails both comparisons.
+    static bool in_range(double steps)
+    {
+        return (steps >= 0.0) & (steps <= static_cast<double>(max_quantized));
+    }
+};
+
+template<int Bits, typename Scale, typename Offset, typename IntFormatter>
+const size_t quantized_formatter<Bits, Scale, Offset, IntFormatter>::chunk_size;
+
+template<int Bits, typename Scale, typename Offset, typename IntFormatter>
+const typename quantized_formatter<Bits, Scale, Offset, IntFormatter>::quantized_type quantized_formatter<Bits, Scale, Offset, IntFormatter>::max_quantized;
+
+template<int Bits, typename Scale, typename Offset = std::ratio<0>, typename IntFormatter = little_endian<(Bits + 7) / 8>>
+quantized_formatter<Bits, Scale, Offset, IntFormatter> create_quantized_formatter(IntFormatter int_formatter = IntFormatter())
+{
+    return quantized_formatter<Bits, Scale, Offset, IntFormatter>(int_formatter);
+}
+
+} // namespace binary
+
+/// @brief quantized_formatter quantizes whole buffers of floating point values at once.
+template<int Bits, typename Scale, typename Offset, typename IntFormatter, typename T>
+struct declare_buffer_formatter< binary::quantized_formatter<Bits, Scale, Offset, IntFormatter>, T, typename std::enable_if< std::is_floating_point<T>::value >::type > : public std::true_type
+{};
+
+static_assert(is_buffer_formatter< binary::quantized_formatter< 16, std::ratio<1, 100> >, double >::value, "quantized_formatter should be a buffer formatter for doubles.");
+static_assert(!is_buffer_formatter< binary::quantized_formatter< 16, std::ratio<1, 100> >, int >::value, "quantized_formatter should not be a buffer formatter for ints.");
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_quantized_formatter_H
@@ -0,0 +1,206 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// record_view.h
+///
+/// This file contains record_view that reads individual fields of a record stored with a tuple_formatter of fixed size formatters,
+/// directly from the serialized data, and mutable_record_view and patch_field() that overwrite individual fields in place.
+/// Offsets of fields are computed at compile time from the formatter type.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_record_view_H
+#define ArbitraryFormatSerializer_record_view_H
+
+#include <arbitrary_format/binary_formatters/fixed_size_of.h>
+#include <arbitrary_format/binary_serializers/MemorySerializer.h>
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+namespace detail
+{
+
+/// @brief Encodes field I of a record with its formatter.
+///        Throws lossy_conversion (or other exceptions of the field formatter) if the value can't be stored, before anything is written.
+template<typename TupleFormatter, size_t I, typename T>
+std::array<uint8_t, fixed_size_of<typename record_field_formatter<TupleFormatter, I>::type>::value> encode_record_field(const T& value)
+{
+    using field_formatter = typename record_field_formatter<TupleFormatter, I>::type;
+
+    std::array<uint8_t, fixed_size_of<field_formatter>::value> fieldData;
+    MemorySaveSerializer serializer(fieldData.data(), fieldData.size());
+    field_formatter().save(serializer, value);
+    if (serializer.position() != fieldData.size())
+    {
+        BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("Field formatter stored different number of bytes than its fixed_size_of."));
+    }
+    return fieldData;
+}
+
+} // namespace detail
+
+/// @brief record_view gives access to fields of a record serialized with TupleFormatter, without loading the whole record.
+///        Every access decodes the field from the underlying data (i.e. with a byte swap), so nothing is cached.
+///        TupleFormatter must be a tuple_formatter of fixed size formatters (see fixed_size_of), that can be default constructed.
+/// @note  View doesn't own the data. Data must hold at least record_view::size bytes.
+template<typename TupleFormatter>
+class record_view
+{
+    const uint8_t* data;
+
+public:
+    static const size_t size = fixed_size_of<TupleFormatter>::value;
+
+    template<size_t I>
+    using field_formatter = typename record_field_formatter<TupleFormatter, I>::type;
+
+    explicit record_view(const uint8_t* data)
+        : data(data)
+    {
+    }
+
+    const uint8_t* get_data() const
+    {
+        return data;
+    }
+
+    /// @brief Loads field I as type T.
+    template<size_t I, typename T>
+    void load(T& value) const
+    {
+        MemoryLoadSerializer serializer(data + field_offset<TupleFormatter, I>::value, fixed_size_of< field_formatter<I> >::value);
+        field_formatter<I>().load(serializer, value);
+    }
+
+    /// @brief Returns field I loaded as type T.
+    template<size_t I, typename T>
+    T get() const
+    {
+        T value;
+        load<I>(value);
+        return value;
+    }
+
+    /// @brief Returns view of field I, that is itself a record stored with a tuple_formatter.
+    template<size_t I>
+    record_view< field_formatter<I> > view() const
+    {
+        return record_view< field_formatter<I> >(data + field_offset<TupleFormatter, I>::value);
+    }
+};
+
+template<typename TupleFormatter>
+const size_t record_view<TupleFormatter>::size;
+
+/// @brief mutable_record_view is a record_view, that can also overwrite individual fields of a record.
+template<typename TupleFormatter>
+class mutable_record_view : public record_view<TupleFormatter>
+{
+    uint8_t* data;
+
+public:
+    template<size_t I>
+    using field_formatter = typename record_field_formatter<TupleFormatter, I>::type;
+
+    explicit mutable_record_view(uint8_t* data)
+        : record_view<TupleFormatter>(data)
+        , data(data)
+    {
+    }
+
+    uint8_t* get_data() const
+    {
+        return data;
+    }
+
+    /// @brief Stores value in field I. Other fields are not touched.
+    ///        Throws lossy_conversion if the value can't be stored by the field formatter. Data is not modified then.
+    template<size_t I, typename T>
+    void set(const T& value) const
+    {
+        auto fieldData = detail::encode_record_field<TupleFormatter, I>(value);
+        std::copy(fieldData.begin(), fieldData.end(), data + field_offset<TupleFormatter, I>::value);
+    }
+
+    /// @brief Returns mutable view of field I, that is itself a record stored with a tuple_formatter.
+    template<size_t I>
+    mutable_record_view< field_formatter<I> > view() const
+    {
+        return mutable_record_view< field_formatter<I> >(data + field_offset<TupleFormatter, I>::value);
+    }
+};
+
+/// @brief Overwrites field I of a record, that starts at given position of the serializer, without touching other fields.
+///        Serializer must define position() and seek() methods. Its position is restored afterwards.
+///        Throws lossy_conversion if the value can't be stored by the field formatter. Nothing is written then.
+template<typename TupleFormatter, size_t I, typename T, typename TSerializer, typename Position>
+void patch_field(TSerializer& serializer, Position recordPosition, const T& value)
+{
+    auto fieldData = detail::encode_record_field<TupleFormatter, I>(value);
+    auto initialPosition = serializer.position();
+    serializer.seek(recordPosition + field_offset<TupleFormatter, I>::value);
+    serializer.saveData(fieldData.data(), fieldData.size());
+    serializer.seek(initialPosition);
+}
+
+/// @brief record_array_view gives access to a sequence of records serialized with TupleFormatter one after another.
+template<typename TupleFormatter>
+class record_array_view
+{
+    const uint8_t* data;
+    size_t count;
+
+public:
+    /// @brief Throws invalid_data if byteCount is not a multiple of record size.
+    record_array_view(const uint8_t* data, size_t byteCount)
+        : data(data)
+        , count(byteCount / record_view<TupleFormatter>::size)
+    {
+        if (byteCount % record_view<TupleFormatter>::size != 0)
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Data size is not a multiple of record size."));
+        }
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    record_view<TupleFormatter> operator[](size_t index) const
+    {
+        return record_view<TupleFormatter>(data + index * record_view<TupleFormatter>::size);
+    }
+};
+
+/// @brief Returns view of a record, and skips it in the serializer. Serializer must have viewData() method (like MemoryLoadSerializer).
+template<typename TupleFormatter, typename TSerializer>
+record_view<TupleFormatter> load_record_view(TSerializer& serializer)
+{
+    return record_view<TupleFormatter>(serializer.viewData(record_view<TupleFormatter>::size));
+}
+
+/// @brief Returns view of count records, and skips them in the serializer. Serializer must have viewData() method (like MemoryLoadSerializer).
+template<typename TupleFormatter, typename TSerializer>
+record_array_view<TupleFormatter> load_record_array_view(TSerializer& serializer, size_t count)
+{
+    return record_array_view<TupleFormatter>(serializer.viewData(count * record_view<TupleFormatter>::size), count * record_view<TupleFormatter>::size);
+}
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_record_view_H
@@ -5,7 +5,9 @@
 /// size_prefix_formatter.h
 ///
 /// This file contains size_prefix_formatter that stores size of the serialized value, followed by the serialized value itself.
-/// NOTE: This formatter requires it's serializer to be ISeekable.
+/// NOTE: This formatter requires it's serializer to be ISeekable. Forward-only serializers can be wrapped in BackpatchingSerializer.
+/// It also contains prepend_size_prefix() and prepend_value() for serializers that can save data in front of data saved before
+/// (ReverseSaveSerializer and HeadroomSaveSerializer).
 ///
 /// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
 /// (c) 2014 Zbigniew Skowron, zbychs@gmail.com
@@ -15,7 +17,9 @@
 #ifndef ArbitraryFormatSerializer_size_prefix_formatter_H
 #define ArbitraryFormatSerializer_size_prefix_formatter_H
 
-#include <arbitrary_format/binary_serializers/ScopedSerializer.h>
+#include <arbitrary_format/binary_serializers/LimitedSerializer.h>
+#include <arbitrary_format/binary_serializers/MemorySerializer.h>
+#include <arbitrary_format/binary_serializers/SizeCountingSerializer.h>
 
 #include <cstdint>
 
@@ -34,8 +38,91 @@ const Formatter& sized_formatter(const Formatter& formatter, uintmax_t byteCount
     return formatter;
 }
 
+namespace detail
+{
+
+/// @brief Calls holdOutput() for serializers that have it (like BackpatchingSerializer).
+template<typename TSerializer>
+auto hold_output(TSerializer& serializer, int) -> decltype(serializer.holdOutput())
+{
+    serializer.holdOutput();
+}
+
+template<typename TSerializer>
+void hold_output(TSerializer&, long)
+{
+}
+
+/// @brief Calls releaseOutput() for serializers that have it (like BackpatchingSerializer).
+template<typename TSerializer>
+auto release_output(TSerializer& serializer, int) -> decltype(serializer.releaseOutput())
+{
+    serializer.releaseOutput();
+}
+
+template<typename TSerializer>
+void release_output(TSerializer&, long)
+{
+}
+
+/// @brief Calls abortOutput() for serializers that have it (like BackpatchingSerializer).
+template<typename TSerializer>
+auto abort_output(TSerializer& serializer, int) -> decltype(serializer.abortOutput())
+{
+    serializer.abortOutput();
+}
+
+template<typename TSerializer>
+void abort_output(TSerializer&, long)
+{
+}
+
+/// @brief Holds serializer's output for its lifetime. If release() wasn't called (i.e. saving threw), the hold is aborted,
+///        so the serializer doesn't stay held, and the partially saved data is dropped.
+template<typename TSerializer>
+class output_hold
+{
+    TSerializer& serializer;
+    bool released;
+
+public:
+    explicit output_hold(TSerializer& serializer)
+        : serializer(serializer)
+        , released(false)
+    {
+        hold_output(serializer, 0);
+    }
+
+    output_hold(const output_hold&) = delete;
+    output_hold& operator=(const output_hold&) = delete;
+
+    void release()
+    {
+        released = true;
+        release_output(serializer, 0);
+    }
+
+    ~output_hold()
+    {
+        if (!released)
+        {
+            try
+            {
+                abort_output(serializer, 0);
+            }
+            catch (...)
+            {
+                // already unwinding - the original exception is the one to report
+            }
+        }
+    }
+};
+
+} // namespace detail
+
 /// @brief size_prefix_formatter will prefix the serialized data with field containing size of data.
 ///        Serializers used with this formatter must define position() and seek() methods.
+///        For forward-only serializers use BackpatchingSerializer: output is held from the size field till the size is patched.
 ///        ValueFormatters used this formatter must have proper sized_formatter overload provided.
 template<typename SizeFormatter, typename ValueFormatter>
 class size_prefix_formatter
@@ -53,8 +140,9 @@ public:
     }
 
     template<typename ValueType, typename TSerializer>
-    void save(TSerializer& serializer, const ValueType& value)
+    void save(TSerializer& serializer, const ValueType& value) const
     {
+        detail::output_hold<TSerializer> hold(serializer);
         auto initialPosition = serializer.position();
 
         uintmax_t byteCount = 0;
@@ -79,12 +167,15 @@ public:
         {
             BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("size_formatter must always store the same number of bytes."));
         }
+
+        serializer.seek(endPosition);
+        hold.release();
     }
 
     /// @brief This method will verify that deserialization read exactly the number of bytes stored in the size field.
     ///        It will throw end_of_input when more data was attepted to be read, and invalid_data if not all data was read.
     template<typename ValueType, typename TSerializer>
-    void load(TSerializer& serializer, ValueType& value)
+    void load(TSerializer& serializer, ValueType& value) const
     {
         uintmax_t byteCount;
         size_formatter.load(serializer, byteCount);
@@ -93,12 +184,43 @@ public:
             BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("Data size cannot be less than zero."));
         }
 
-        ScopedSerializer<TSerializer> scopedSerializer(serializer, byteCount);
-        sized_formatter(value_formatter, byteCount).load(scopedSerializer, value);
-        scopedSerializer.verifyAllBytesProcessed();
+        load_limited(serializer, byteCount, sized_formatter(value_formatter, byteCount), value);
     }
 };
 
+/// @brief Saves value, formatted with formatter, in front of all data saved so far. Serializer must have reservePrepend() and commitPrepend() methods.
+///        The value is formatted twice: once into SizeCountingSerializer to measure it, and then front to back straight into the space reserved in front of the data,
+///        so there is no temporary buffer and no copy. The formatter must not seek, and must save the same bytes both times.
+///        Throws serialization_exception if the second pass saves a different number of bytes than the first one. The data is left unchanged then.
+template<typename Formatter, typename ValueType, typename TSerializer>
+void prepend_value(TSerializer& serializer, const ValueType& value, const Formatter& formatter = Formatter())
+{
+    SizeCountingSerializer sizeCounter;
+    formatter.save(sizeCounter, value);
+    size_t byteCount = static_cast<size_t>(sizeCounter.getByteCount());
+
+    MemorySaveSerializer valueSerializer(serializer.reservePrepend(byteCount), byteCount);
+    formatter.save(valueSerializer, value);
+    if (valueSerializer.position() != byteCount)
+    {
+        BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("Formatter saved different number of bytes when saved again."));
+    }
+
+    serializer.commitPrepend(byteCount);
+}
+
+/// @brief Saves byteCount, formatted with size_formatter, in front of all data saved so far. Serializer must have prependData() method.
+///        With ReverseSaveSerializer prepend the payload first, and then its size (difference of positions) - no seeks, and no copying of the payload.
+///        Throws serialization_exception if size_formatter stores more than 16 bytes.
+template<typename SizeFormatter, typename TSerializer>
+void prepend_size_prefix(TSerializer& serializer, uintmax_t byteCount, const SizeFormatter& size_formatter = SizeFormatter())
+{
+    uint8_t sizeData[16];
+    MemorySaveSerializer sizeSerializer(sizeData, sizeof(sizeData));
+    size_formatter.save(sizeSerializer, byteCount);
+    serializer.prependData(sizeData, sizeSerializer.position());
+}
+
 template<typename SizeFormatter, typename ValueFormatter>
 size_prefix_formatter<SizeFormatter, ValueFormatter> create_size_prefix_formatter(SizeFormatter size_formatter = SizeFormatter(), ValueFormatter value_formatter = ValueFormatter())
 {
@@ -39,21 +39,32 @@ public:
     {
     }
 
-    template<typename TSerializer>
-    void save(TSerializer& serializer, const std::basic_string<CharT>& string) const
+    template<typename Traits, typename Allocator, typename TSerializer>
+    void save(TSerializer& serializer, const std::basic_string<CharT, Traits, Allocator>& string) const
     {
         size_formatter.save(serializer, string.length());
         save_buffer(serializer, string.length(), &string[0], char_formatter);   /// @note This is ok in C++ 11, even for empty strings.
     }
 
+    /// @brief Stores a null-terminated string, like string literals.
+    /// @note  Strings are saved through a template on Traits and Allocator, that doesn't accept implicit conversions,
+    ///        so without this overload string literals and const CharT* wouldn't be accepted anymore.
     template<typename TSerializer>
-    void load(TSerializer& serializer, std::basic_string<CharT>& string) const
+    void save(TSerializer& serializer, const CharT* string) const
+    {
+        size_t string_size = std::char_traits<CharT>::length(string);
+        size_formatter.save(serializer, string_size);
+        save_buffer(serializer, string_size, string, char_formatter);
+    }
+
+    /// @note Strings of characters loaded verbatim are not zero-filled before loading. See load_sequence().
+    template<typename Traits, typename Allocator, typename TSerializer>
+    void load(TSerializer& serializer, std::basic_string<CharT, Traits, Allocator>& string) const
     {
         size_t string_size;
         size_formatter.load(serializer, string_size);
 
-        string.resize(string_size);
-        load_buffer(serializer, string_size, &string[0], char_formatter);   /// @note This is ok in C++ 11, even for empty strings.
+        load_sequence(serializer, string_size, string, char_formatter);
     }
 };
 
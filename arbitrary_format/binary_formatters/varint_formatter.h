@@ -0,0 +1,148 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// varint_formatter.h
+///
+/// This file contains varint_formatter that formats integral types on variable number of bytes (LEB128, as used by Google Protocol Buffers).
+/// Signed types are zigzag encoded, so small negative values are stored on few bytes too.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_varint_formatter_H
+#define ArbitraryFormatSerializer_varint_formatter_H
+
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+namespace detail
+{
+
+template<typename T, typename Enable = void>
+struct varint_integer
+{
+    using type = T;
+};
+
+template<typename T>
+struct varint_integer< T, typename std::enable_if<std::is_enum<T>::value>::type >
+{
+    using type = typename std::underlying_type<T>::type;
+};
+
+} // namespace detail
+
+/// @brief varint_formatter stores integers on 7 bits per byte, least significant group first.
+///        Most significant bit of every byte is set if more bytes follow.
+class varint_formatter
+{
+public:
+    /// @brief Stores given bool on one byte.
+    template<typename TSerializer>
+    void save(TSerializer& serializer, bool b) const
+    {
+        save(serializer, static_cast<unsigned int>(b));
+    }
+
+    /// @brief Loads given bool.
+    ///        Throws invalid_data if loaded value is neither 0 nor 1.
+    template<typename TSerializer>
+    void load(TSerializer& serializer, bool& b) const
+    {
+        unsigned int value;
+        load(serializer, value);
+        if (value > 1)
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Bool value must be 0 or 1."));
+        }
+        b = (value != 0);
+    }
+
+    template<typename T, typename TSerializer>
+    typename std::enable_if< std::is_integral<T>::value || std::is_enum<T>::value >::type
+    save(TSerializer& serializer, const T& value) const
+    {
+        using Integer = typename detail::varint_integer<T>::type;
+        using Unsigned = typename std::make_unsigned<Integer>::type;
+
+        auto integer = static_cast<Integer>(value);
+        auto encoded = std::is_signed<Integer>::value ? zigzag_encode(integer) : static_cast<Unsigned>(integer);
+
+        uint8_t buffer[max_bytes];
+        size_t size = 0;
+        while (encoded >= 0x80)
+        {
+            buffer[size++] = static_cast<uint8_t>(encoded | 0x80);
+            encoded >>= 7;
+        }
+        buffer[size++] = static_cast<uint8_t>(encoded);
+
+        serializer.saveData(buffer, size);
+    }
+
+    /// @brief Loads a varint.
+    ///        Throws invalid_data if the stored value doesn't fit in T.
+    template<typename T, typename TSerializer>
+    typename std::enable_if< std::is_integral<T>::value || std::is_enum<T>::value >::type
+    load(TSerializer& serializer, T& value) const
+    {
+        using Integer = typename detail::varint_integer<T>::type;
+        using Unsigned = typename std::make_unsigned<Integer>::type;
+
+        uintmax_t encoded = 0;
+        int shift = 0;
+        uint8_t byte;
+        do
+        {
+            serializer.loadData(&byte, 1);
+            if ( (shift >= std::numeric_limits<uintmax_t>::digits) || ((std::numeric_limits<uintmax_t>::digits - shift < 7) && ((byte & 0x7F) >> (std::numeric_limits<uintmax_t>::digits - shift))) )
+            {
+                BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Varint is too long."));
+            }
+            encoded |= static_cast<uintmax_t>(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+
+        if (encoded > std::numeric_limits<Unsigned>::max())
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Varint value doesn't fit in the destination type."));
+        }
+
+        auto unsigned_value = static_cast<Unsigned>(encoded);
+        value = static_cast<T>(std::is_signed<Integer>::value ? zigzag_decode<Integer>(unsigned_value) : static_cast<Integer>(unsigned_value));
+    }
+
+private:
+    static const size_t max_bytes = (std::numeric_limits<uintmax_t>::digits + 6) / 7;
+
+    /// @brief Maps signed integers to unsigned ones: 0 -> 0, -1 -> 1, 1 -> 2, -2 -> 3 etc.
+    template<typename Integer>
+    static typename std::make_unsigned<Integer>::type zigzag_encode(Integer value)
+    {
+        using Unsigned = typename std::make_unsigned<Integer>::type;
+        return static_cast<Unsigned>( (static_cast<Unsigned>(value) << 1) ^ static_cast<Unsigned>(value < 0 ? ~Unsigned() : Unsigned()) );
+    }
+
+    template<typename Integer>
+    static Integer zigzag_decode(typename std::make_unsigned<Integer>::type value)
+    {
+        using Unsigned = typename std::make_unsigned<Integer>::type;
+        return static_cast<Integer>( static_cast<Unsigned>(value >> 1) ^ static_cast<Unsigned>(-static_cast<Unsigned>(value & 1)) );
+    }
+};
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_varint_formatter_H
@@ -0,0 +1,161 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// BackpatchingSerializer.h
+///
+/// This file contains BackpatchingSerializer that adds position() and seek() to forward-only saving serializers (like CoutSerializer),
+/// by buffering output that might still be patched.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_BackpatchingSerializer_H
+#define ArbitraryFormatSerializer_BackpatchingSerializer_H
+
+#include <arbitrary_format/binary_serializers/ISerializer.h>
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+/// @brief BackpatchingSerializer is a saving serializer, that passes data to a forward-only serializer, but allows for patching data that's not sent yet.
+///        holdOutput() starts holding data back, so it can be patched with seek() and saveData(). releaseOutput() ends it.
+///        Holds nest: data is sent to the underlying serializer only when the outermost hold is released.
+///        Data saved while nothing is held is sent immediately, without buffering.
+///        size_prefix_formatter holds the output for the time of saving its value, so it can be used with this serializer.
+///        If saving fails, size_prefix_formatter calls abortOutput(), so the partially saved value is dropped, and later values are sent normally.
+/// @note  Data that's still held when the serializer is destroyed is not sent.
+template<typename TSerializer>
+class BackpatchingSerializer
+{
+    TSerializer& serializer;
+    std::vector<uint8_t> buffer;
+    uintmax_t sentBytes;        ///< @note Number of bytes passed to the underlying serializer. buffer holds data following them.
+    size_t bufferPosition;
+    std::vector< std::pair<size_t, size_t> > holdStarts;    ///< @note Buffer size and position at each holdOutput(), innermost last.
+
+public:
+    explicit BackpatchingSerializer(TSerializer& serializer)
+        : serializer(serializer)
+        , sentBytes(0)
+        , bufferPosition(0)
+    {
+        static_assert(is_saving_serializer<TSerializer>::value, "BackpatchingSerializer requires a saving serializer.");
+    }
+
+    uintmax_t position() const
+    {
+        return sentBytes + bufferPosition;
+    }
+
+    /// @brief Seeks to given position. Only positions of data that is held can be sought.
+    ///        Throws serialization_exception if the position was already sent, or is past the end of data.
+    void seek(uintmax_t position)
+    {
+        if ((position < sentBytes) || (position > sentBytes + buffer.size()))
+        {
+            BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("Can't seek outside of data held by BackpatchingSerializer."));
+        }
+
+        bufferPosition = static_cast<size_t>(position - sentBytes);
+    }
+
+    /// @brief Starts holding data back, until matching releaseOutput().
+    void holdOutput()
+    {
+        holdStarts.emplace_back(buffer.size(), bufferPosition);
+    }
+
+    /// @brief Ends hold started by holdOutput(). If it was the outermost hold, all held data is sent to the underlying serializer.
+    void releaseOutput()
+    {
+        if (holdStarts.empty())
+        {
+            BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("releaseOutput() without holdOutput()."));
+        }
+
+        holdStarts.pop_back();
+        if (holdStarts.empty())
+        {
+            flush();
+        }
+    }
+
+    /// @brief Ends hold started by holdOutput(), dropping data appended since then, and going back to the position it started at.
+    ///        If it was the outermost hold, data held before it is sent to the underlying serializer.
+    /// @note  Data overwritten (not appended) during the hold is not restored.
+    void abortOutput()
+    {
+        if (holdStarts.empty())
+        {
+            BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("abortOutput() without holdOutput()."));
+        }
+
+        buffer.resize(holdStarts.back().first);
+        bufferPosition = holdStarts.back().second;
+        holdStarts.pop_back();
+        if (holdStarts.empty())
+        {
+            flush();
+        }
+    }
+
+    /// @brief Returns number of bytes held.
+    size_t getHeldSize() const
+    {
+        return buffer.size();
+    }
+
+public:
+    using saving_serializer = std::true_type;
+
+    void saveData(const uint8_t* data, size_t size)
+    {
+        if (holdStarts.empty() && buffer.empty())
+        {
+            serializer.saveData(data, size);
+            sentBytes += size;
+            return;
+        }
+
+        // overwrite what we can, and append the rest
+        size_t overwritten = std::min(size, buffer.size() - bufferPosition);
+        std::copy(data, data + overwritten, buffer.begin() + bufferPosition);
+        buffer.insert(buffer.end(), data + overwritten, data + size);
+        bufferPosition += size;
+    }
+
+private:
+    /// @note Data after the current position is sent too (it was saved, and seeking back was just a patch), and position moves to the end of data.
+    void flush()
+    {
+        if (!buffer.empty())
+        {
+            serializer.saveData(buffer.data(), buffer.size());
+        }
+        sentBytes += buffer.size();
+        buffer.clear();
+        bufferPosition = 0;
+    }
+};
+
+template<typename TSerializer>
+BackpatchingSerializer<TSerializer> make_backpatching_serializer(TSerializer& serializer)
+{
+    return BackpatchingSerializer<TSerializer>(serializer);
+}
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_BackpatchingSerializer_H
@@ -0,0 +1,145 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// HeadroomSaveSerializer.h
+///
+/// This file contains HeadroomSaveSerializer that writes to a vector, and keeps free space in front of the data,
+/// so that headers can be prepended after the data is saved.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_HeadroomSaveSerializer_H
+#define ArbitraryFormatSerializer_HeadroomSaveSerializer_H
+
+#include <arbitrary_format/binary_serializers/ISerializer.h>
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+/// @brief HeadroomSaveSerializer saves data like VectorSaveSerializer, but keeps headroom - free space in front of the data.
+///        prependData() puts bytes in the headroom, so envelopes and size prefixes can be added after the payload is saved, without moving it.
+///        If headroom runs out it's doubled, and the data is moved once.
+/// @note  Positions are relative to the front of the data, so prepending data moves the current position by the number of bytes prepended.
+/// @note  Data can be prepended only in front of the whole buffer, so this helps with one outer envelope, not with nested size prefixes.
+///        For those use size_prefix_formatter (it seeks back over the payload), or build the data back to front with ReverseSaveSerializer.
+class HeadroomSaveSerializer
+{
+    std::vector<uint8_t> buffer;    ///< @note Data occupies [front, buffer.size()).
+    size_t front;
+    size_t pos;
+
+public:
+    explicit HeadroomSaveSerializer(size_t headroom = 64)
+        : buffer(headroom)
+        , front(headroom)
+        , pos(0)
+    {
+    }
+
+    const uint8_t* getData() const
+    {
+        return buffer.data() + front;
+    }
+
+    size_t getDataSize() const
+    {
+        return buffer.size() - front;
+    }
+
+    std::vector<uint8_t> getDataVector() const
+    {
+        return std::vector<uint8_t>(buffer.begin() + front, buffer.end());
+    }
+
+    /// @brief Returns number of bytes that can be prepended without moving the data.
+    size_t getHeadroom() const
+    {
+        return front;
+    }
+
+    size_t position() const
+    {
+        return pos;
+    }
+
+    void seek(size_t position)
+    {
+        if (position > getDataSize())
+        {
+            buffer.resize(front + position);
+        }
+
+        pos = position;
+    }
+
+    /// @brief Saves data in front of all data saved so far.
+    void prependData(const uint8_t* data, size_t size)
+    {
+        std::copy(data, data + size, reservePrepend(size));
+        commitPrepend(size);
+    }
+
+    /// @brief Makes room for size bytes in the headroom, and returns pointer to it.
+    ///        The bytes become part of the data only after commitPrepend(size), so if filling them fails the data is unchanged.
+    uint8_t* reservePrepend(size_t size)
+    {
+        if (size > front)
+        {
+            grow(size);
+        }
+
+        return buffer.data() + front - size;
+    }
+
+    /// @brief Adds size bytes reserved with reservePrepend() in front of the data.
+    void commitPrepend(size_t size)
+    {
+        front -= size;
+        pos += size;
+    }
+
+public:
+    using saving_serializer = std::true_type;
+
+    void saveData(const uint8_t* data, size_t size)
+    {
+        size_t end = front + pos;
+        if (end == buffer.size())
+        {
+            buffer.insert(buffer.end(), data, data + size);
+            pos += size;
+            return;
+        }
+
+        // overwrite what we can, and append the rest - without zero-filling it first
+        size_t overwritten = std::min(size, buffer.size() - end);
+        std::copy(data, data + overwritten, buffer.begin() + end);
+        buffer.insert(buffer.end(), data + overwritten, data + size);
+        pos += size;
+    }
+
+private:
+    /// @brief Enlarges headroom to at least twice its size, and at least size bytes.
+    void grow(size_t size)
+    {
+        size_t newHeadroom = std::max(2 * front, size);
+        buffer.insert(buffer.begin(), newHeadroom - front, 0);
+        front = newHeadroom;
+    }
+};
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_HeadroomSaveSerializer_H
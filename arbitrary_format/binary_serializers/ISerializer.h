@@ -18,6 +18,7 @@
 #include <arbitrary_format/serialization_exceptions.h>
 #include <arbitrary_format/utility/has_member.h>
 
+#include <type_traits>
 #include <utility>
 
 #include <cstdint>
@@ -222,6 +223,16 @@ private:
 AFS_GENERATE_HAS_MEMBER(position);
 AFS_GENERATE_HAS_MEMBER(seek);
 
+/// @brief has_view_data is true for serializers that can return pointers to their data instead of copying it,
+///        with a method: const uint8_t* viewData(size_t size).
+template<typename TSerializer, typename Enable = void>
+struct has_view_data : public std::false_type
+{};
+
+template<typename TSerializer>
+struct has_view_data<TSerializer, decltype(void(std::declval<TSerializer&>().viewData(size_t(0))))> : public std::true_type
+{};
+
 /// @brief AnySerializer is a decorator, that converts a non-polymorphic serializer into a polymorphic serializer.
 /// @param ForceCreate  If true, then type will be created, but missing methods in TSerializer will result in generation of methods that throw not_implemented exception.
 ///                     If false, then type will not be created if there are any missing methods in TSerializer.
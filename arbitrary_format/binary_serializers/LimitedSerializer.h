@@ -0,0 +1,229 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// LimitedSerializer.h
+///
+/// This file contains LimitedSerializer that checks nested byte limits, and load_limited() function that uses it,
+/// so that nested size prefixes don't need nested ScopedSerializers.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_LimitedSerializer_H
+#define ArbitraryFormatSerializer_LimitedSerializer_H
+
+#include <arbitrary_format/binary_serializers/ISerializer.h>
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+/// @brief LimitedSerializer works like ScopedSerializer, but its limits nest: pushLimit() starts a limit inside the current one, and popLimit() ends it.
+///        A nested limit can never end after the enclosing one, so only the innermost limit is checked,
+///        and any nesting depth costs one check per saveData() or loadData() call.
+///        The serializer keeps only the innermost limit: pushLimit() returns the enclosing one, and the caller passes it back to popLimit(),
+///        so enclosing limits live on the C++ stack and nesting never allocates.
+///        All nesting levels use the same serializer type, so formatters are instantiated once, not once per nesting level.
+///        Without any limit pushed all data is passed through.
+template<typename TSerializer>
+class LimitedSerializer
+{
+    TSerializer& serializer;
+    uintmax_t bytesProcessed;
+    uintmax_t currentLimit;     ///< @note Position (in bytes processed) where the innermost limit ends.
+
+public:
+    explicit LimitedSerializer(TSerializer& serializer)
+        : serializer(serializer)
+        , bytesProcessed(0)
+        , currentLimit(std::numeric_limits<uintmax_t>::max())
+    {
+        static_assert(is_saving_serializer<TSerializer>::value || is_loading_serializer<TSerializer>::value, "Serializer isn't a loading or saving serializer. Don't know how it should work.");
+    }
+
+    /// @brief Starts a limit of byteCount bytes, inside the current limit.
+    ///        Returns the enclosing limit, that must be passed to popLimit() or restoreLimit() when this limit ends.
+    ///        Throws end_of_input (or end_of_space) if the current limit doesn't leave byteCount bytes.
+    uintmax_t pushLimit(uintmax_t byteCount)
+    {
+        uintmax_t bytesLeft = getBytesLeft();
+        if (byteCount > bytesLeft)
+        {
+            throwLimitExceeded(byteCount - bytesLeft);
+        }
+
+        uintmax_t outerLimit = currentLimit;
+        currentLimit = bytesProcessed + byteCount;
+        return outerLimit;
+    }
+
+    /// @brief Ends the innermost limit, verifying that exactly the number of bytes specified by it was processed.
+    ///        outerLimit is the value returned by the matching pushLimit().
+    ///        It will throw invalid_data exception if not all data was processed. The limit is not ended then.
+    void popLimit(uintmax_t outerLimit)
+    {
+        if (bytesProcessed < currentLimit)
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_requested_this_many_bytes_more(currentLimit - bytesProcessed));
+        }
+
+        currentLimit = outerLimit;
+    }
+
+    /// @brief Ends the innermost limit without verifying it. Used when a load nested in the limit has failed.
+    void restoreLimit(uintmax_t outerLimit)
+    {
+        currentLimit = outerLimit;
+    }
+
+    /// @brief Returns number of bytes that has been processed by this serializer so far.
+    uintmax_t getBytesProcessed() const
+    {
+        return bytesProcessed;
+    }
+
+    /// @brief Returns number of bytes that are still left to be processed in the innermost limit.
+    uintmax_t getBytesLeft() const
+    {
+        return currentLimit - bytesProcessed;
+    }
+
+    bool saving() const
+    {
+        return is_serializer_saving(serializer);
+    }
+
+public:
+    using saving_serializer = is_saving_serializer<TSerializer>;
+    using loading_serializer = is_loading_serializer<TSerializer>;
+
+    template<typename T>
+    typename std::enable_if<saving_serializer::value && std::is_same<T, uint8_t>::value>::type
+    saveData(const T* data, size_t size)
+    {
+        countData(size);
+        serializer.saveData(data, size);
+    }
+
+    template<typename T>
+    typename std::enable_if<loading_serializer::value && std::is_same<T, uint8_t>::value>::type
+    loadData(T* data, size_t size)
+    {
+        countData(size);
+        serializer.loadData(data, size);
+    }
+
+    /// @brief Available if the underlying serializer can return views of its data (like MemoryLoadSerializer).
+    template<typename Serializer = TSerializer>
+    auto viewData(size_t size) -> decltype(std::declval<Serializer&>().viewData(size))
+    {
+        countData(size);
+        return serializer.viewData(size);
+    }
+
+    /// @brief Available if the underlying serializer has position(). Returns position of the underlying serializer,
+    ///        so that aligned_formatter aligns data relative to the whole buffer.
+    template<typename Serializer = TSerializer>
+    auto position() -> decltype(std::declval<Serializer&>().position())
+    {
+        return serializer.position();
+    }
+
+private:
+    void countData(size_t size)
+    {
+        if (size > currentLimit - bytesProcessed)
+        {
+            throwLimitExceeded(size - (currentLimit - bytesProcessed));
+        }
+        bytesProcessed += size;
+    }
+
+    void throwLimitExceeded(uintmax_t bytesMore) const
+    {
+        if (saving())
+        {
+            BOOST_THROW_EXCEPTION(end_of_space() << errinfo_requested_this_many_bytes_more(bytesMore));
+        }
+        else
+        {
+            BOOST_THROW_EXCEPTION(end_of_input() << errinfo_requested_this_many_bytes_more(bytesMore));
+        }
+    }
+};
+
+namespace detail
+{
+
+/// @brief Pushes a limit on a LimitedSerializer for its lifetime.
+///        end() verifies and ends the limit; if it isn't called (or throws) the destructor ends the limit without verifying it,
+///        so that a caller catching the exception can keep using the serializer.
+template<typename TSerializer>
+class limit_scope
+{
+    LimitedSerializer<TSerializer>& serializer;
+    uintmax_t outerLimit;
+    bool ended;
+
+public:
+    limit_scope(LimitedSerializer<TSerializer>& serializer, uintmax_t byteCount)
+        : serializer(serializer)
+        , outerLimit(serializer.pushLimit(byteCount))
+        , ended(false)
+    {
+    }
+
+    limit_scope(const limit_scope&) = delete;
+    limit_scope& operator=(const limit_scope&) = delete;
+
+    void end()
+    {
+        serializer.popLimit(outerLimit);
+        ended = true;
+    }
+
+    ~limit_scope()
+    {
+        if (!ended)
+        {
+            serializer.restoreLimit(outerLimit);
+        }
+    }
+};
+
+} // namespace detail
+
+/// @brief Loads value with formatter, verifying that it consumed exactly byteCount bytes.
+///        Throws end_of_input when more data was attempted to be read, and invalid_data if not all data was read.
+///        This overload is used for nested loads: it pushes a limit on the LimitedSerializer, instead of wrapping it again.
+template<typename Formatter, typename ValueType, typename TSerializer>
+void load_limited(LimitedSerializer<TSerializer>& serializer, uintmax_t byteCount, const Formatter& formatter, ValueType& value)
+{
+    detail::limit_scope<TSerializer> limit(serializer, byteCount);
+    formatter.load(serializer, value);
+    limit.end();
+}
+
+/// @brief Loads value with formatter, verifying that it consumed exactly byteCount bytes.
+///        The serializer is wrapped in a LimitedSerializer, so loads nested in this one only push their limits on it.
+template<typename Formatter, typename ValueType, typename TSerializer>
+void load_limited(TSerializer& serializer, uintmax_t byteCount, const Formatter& formatter, ValueType& value)
+{
+    LimitedSerializer<TSerializer> limitedSerializer(serializer);
+    load_limited(limitedSerializer, byteCount, formatter, value);
+}
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_LimitedSerializer_H
@@ -43,7 +43,7 @@ public:
         static_assert(sizeof(T) == 1, "Size of data in memory buffer must be 1 to avoid element cout / byte count mismatch errors.");
     }
 
-    template<int Size>
+    template<size_t Size>
     explicit MemorySaveSerializer(std::array<uint8_t, Size>& buffer)
         : MemorySaveSerializer(buffer.data(), Size)
     {
@@ -105,7 +105,7 @@ public:
         static_assert(sizeof(T) == 1, "Size of data in memory buffer must be 1 to avoid element cout / byte count mismatch errors.");
     }
 
-    template<typename T, int Size>
+    template<typename T, size_t Size>
     explicit MemoryLoadSerializer(const std::array<T, Size>& buffer)
         : MemoryLoadSerializer(buffer.data(), Size)
     {
@@ -144,6 +144,20 @@ public:
         std::copy_n(buffer + bufferPosition, size, data);
         bufferPosition += size;
     }
+
+    /// @brief Returns pointer to the next size bytes of the buffer, and skips them. Data is not copied.
+    ///        Returned pointer is valid as long as the underlying memory buffer.
+    const uint8_t* viewData(size_t size)
+    {
+        if (bufferPosition + size > bufferSize)
+        {
+            BOOST_THROW_EXCEPTION(end_of_input() << errinfo_requested_this_many_bytes_more(bufferPosition + size - bufferSize));
+        }
+
+        const uint8_t* data = buffer + bufferPosition;
+        bufferPosition += size;
+        return data;
+    }
 };
 
 } // namespace binary
@@ -0,0 +1,109 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// ReverseSaveSerializer.h
+///
+/// This file contains ReverseSaveSerializer that fills its buffer from the end, so that data prepended later ends up in front of data prepended earlier.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_ReverseSaveSerializer_H
+#define ArbitraryFormatSerializer_ReverseSaveSerializer_H
+
+#include <arbitrary_format/binary_serializers/ISerializer.h>
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+/// @brief ReverseSaveSerializer builds data back to front: every prependData() call puts its bytes in front of everything saved before.
+///        This allows for saving a payload first, and then its size prefix or envelope, without seeking or moving the payload.
+///        Fields of a record must be prepended in reverse order (last field first).
+///        It's not a saving serializer, because formatters that call saveData() more than once (like string_formatter) would come out reversed.
+///        Use prepend_value() to prepend values of any formatter: it reserves space in front of the data, and the formatter saves front to back straight into it.
+///        Use prepend_size_prefix() to prepend sizes.
+/// @note  position() is the number of bytes saved so far, so the difference of positions is the size of data saved in between.
+class ReverseSaveSerializer
+{
+    std::vector<uint8_t> buffer;    ///< @note Data occupies [front, buffer.size()).
+    size_t front;
+
+public:
+    explicit ReverseSaveSerializer(size_t initialCapacity = 256)
+        : buffer(initialCapacity)
+        , front(initialCapacity)
+    {
+    }
+
+    const uint8_t* getData() const
+    {
+        return buffer.data() + front;
+    }
+
+    size_t getDataSize() const
+    {
+        return buffer.size() - front;
+    }
+
+    std::vector<uint8_t> getDataVector() const
+    {
+        return std::vector<uint8_t>(buffer.begin() + front, buffer.end());
+    }
+
+    size_t position() const
+    {
+        return getDataSize();
+    }
+
+    /// @brief Saves data in front of all data saved before.
+    void prependData(const uint8_t* data, size_t size)
+    {
+        std::copy(data, data + size, reservePrepend(size));
+        commitPrepend(size);
+    }
+
+    /// @brief Makes room for size bytes in front of the data, and returns pointer to it.
+    ///        The bytes become part of the data only after commitPrepend(size), so if filling them fails the data is unchanged.
+    uint8_t* reservePrepend(size_t size)
+    {
+        if (size > front)
+        {
+            grow(size);
+        }
+
+        return buffer.data() + front - size;
+    }
+
+    /// @brief Adds size bytes reserved with reservePrepend() in front of the data.
+    void commitPrepend(size_t size)
+    {
+        front -= size;
+    }
+
+private:
+    /// @brief Moves data to the end of a buffer at least twice as big, so that there are at least size free bytes in front of it.
+    void grow(size_t size)
+    {
+        size_t dataSize = getDataSize();
+        size_t newCapacity = std::max(2 * buffer.size(), dataSize + size);
+        std::vector<uint8_t> newBuffer(newCapacity);
+        std::copy(buffer.begin() + front, buffer.end(), newBuffer.end() - dataSize);
+        buffer.swap(newBuffer);
+        front = newCapacity - dataSize;
+    }
+};
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_ReverseSaveSerializer_H
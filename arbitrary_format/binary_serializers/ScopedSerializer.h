@@ -19,6 +19,8 @@
 #include <arbitrary_format/serialization_exceptions.h>
 
 #include <cstdint>
+#include <type_traits>
+#include <utility>
 
 namespace arbitrary_format
 {
@@ -93,6 +95,22 @@ public:
         serializer.loadData(data, size);
     }
 
+    /// @brief Available if the underlying serializer can return views of its data (like MemoryLoadSerializer).
+    template<typename Serializer = TSerializer>
+    auto viewData(size_t size) -> decltype(std::declval<Serializer&>().viewData(size))
+    {
+        countData(size);
+        return serializer.viewData(size);
+    }
+
+    /// @brief Available if the underlying serializer has position(). Returns position of the underlying serializer,
+    ///        so that aligned_formatter aligns data relative to the whole buffer.
+    template<typename Serializer = TSerializer>
+    auto position() -> decltype(std::declval<Serializer&>().position())
+    {
+        return serializer.position();
+    }
+
 private:
     void countData(size_t size)
     {
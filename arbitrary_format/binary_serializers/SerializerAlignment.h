@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// SerializerAlignment.h
+///
+/// This file contains align_serializer() that moves serializer's position to a multiple of given alignment,
+/// by saving (or skipping on load) zero bytes of padding.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_SerializerAlignment_H
+#define ArbitraryFormatSerializer_SerializerAlignment_H
+
+#include <arbitrary_format/binary_serializers/ISerializer.h>
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace arbitrary_format
+{
+namespace binary
+{
+
+namespace detail
+{
+
+static const size_t max_padding_chunk = 64;
+
+template<typename TSerializer>
+void process_padding(TSerializer& serializer, size_t padding, std::true_type)
+{
+    const uint8_t zeros[max_padding_chunk] = {};
+    while (padding > 0)
+    {
+        size_t chunk = std::min(padding, max_padding_chunk);
+        serializer.saveData(zeros, chunk);
+        padding -= chunk;
+    }
+}
+
+template<typename TSerializer>
+void process_padding(TSerializer& serializer, size_t padding, std::false_type)
+{
+    uint8_t loaded[max_padding_chunk];
+    while (padding > 0)
+    {
+        size_t chunk = std::min(padding, max_padding_chunk);
+        serializer.loadData(loaded, chunk);
+        if (std::any_of(loaded, loaded + chunk, [](uint8_t byte) { return byte != 0; }))
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Alignment padding is not zero."));
+        }
+        padding -= chunk;
+    }
+}
+
+} // namespace detail
+
+/// @brief Returns number of bytes of padding needed to move given position to a multiple of alignment.
+inline size_t alignment_padding(uintmax_t position, size_t alignment)
+{
+    return static_cast<size_t>((alignment - position % alignment) % alignment);
+}
+
+/// @brief Moves serializer's position to a multiple of alignment. On save zero bytes are written as padding.
+///        On load padding is skipped, and invalid_data is thrown if it's not zero.
+///        Serializers used with this function must define position() method. Alignment is relative to the position 0 of the serializer,
+///        so the data is aligned in memory only if the beginning of the buffer is (i.e. it's a mmapped file, or an allocated buffer).
+template<typename TSerializer>
+void align_serializer(TSerializer& serializer, size_t alignment)
+{
+    if (alignment == 0)
+    {
+        BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("Alignment must be greater than zero."));
+    }
+
+    size_t padding = alignment_padding(static_cast<uintmax_t>(serializer.position()), alignment);
+    detail::process_padding(serializer, padding, is_saving_serializer<TSerializer>());
+}
+
+} // namespace binary
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_SerializerAlignment_H
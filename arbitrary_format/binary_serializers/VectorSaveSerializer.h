@@ -17,6 +17,7 @@
 #include <arbitrary_format/binary_serializers/ISerializer.h>
 #include <arbitrary_format/serialization_exceptions.h>
 
+#include <algorithm>
 #include <vector>
 #include <cstdint>
 
@@ -67,12 +68,10 @@ public:
             return;
         }
 
-        if (pos + size > buffer.size())
-        {
-            buffer.resize(pos + size);
-        }
-
-        std::copy(data, data + size, buffer.begin() + pos);
+        // overwrite what we can, and append the rest - without zero-filling it first
+        size_t overwritten = std::min(size, buffer.size() - pos);
+        std::copy(data, data + overwritten, buffer.begin() + pos);
+        buffer.insert(buffer.end(), data + overwritten, data + size);
         pos += size;
     }
 };
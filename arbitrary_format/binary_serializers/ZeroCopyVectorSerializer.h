@@ -17,6 +17,7 @@
 #include <arbitrary_format/binary_serializers/ISerializer.h>
 #include <arbitrary_format/binary_serializers/IZeroCopySerializer.h>
 #include <arbitrary_format/serialization_exceptions.h>
+#include <arbitrary_format/utility/default_init_allocator.h>
 
 #include <vector>
 
@@ -25,9 +26,10 @@ namespace arbitrary_format
 namespace binary
 {
 
+/// @note Buffer uses default_init_allocator, so growing it to hand out a new chunk doesn't zero-fill the chunk.
 class ZeroCopyVectorSaveSerializer : public SerializerMixin<ZeroCopyVectorSaveSerializer>, public IZeroCopySerializer
 {
-    std::vector<uint8_t> buffer;
+    std::vector<uint8_t, default_init_allocator<uint8_t>> buffer;
     size_t chunkSize;
     size_t position;
 public:
@@ -37,9 +39,10 @@ public:
     {
     }
 
-    const std::vector<uint8_t>& getData()
+    /// @note Returns a copy, converted to a plain std::vector<uint8_t>, so that the allocator of the buffer doesn't leak into the interface.
+    std::vector<uint8_t> getData() const
     {
-        return buffer;
+        return std::vector<uint8_t>(buffer.begin(), buffer.end());
     }
 
     bool saving() const
@@ -15,14 +15,20 @@
 #ifndef ArbitraryFormatSerializer_any_formatter_H
 #define ArbitraryFormatSerializer_any_formatter_H
 
-#include <memory>
+#include <arbitrary_format/formatters/type_formatter.h>
+#include <arbitrary_format/utility/small_buffer_storage.h>
+
+#include <type_traits>
 
 #include <boost/any.hpp>
+#include <boost/throw_exception.hpp>
 
 namespace arbitrary_format
 {
 
-/// @todo: Fix this for saving and loading only serializers.
+/// @brief any_formatter stores the formatter in a small buffer, and calls it through a table of function pointers.
+///        Objects can be passed either as boost::any, or directly, as objects of the formatted type.
+///        Throws boost::bad_any_cast if object is not of the formatted type.
 template<typename TSerializer>
 class any_formatter
 {
@@ -32,61 +38,107 @@ public:
     ///       Use make_any_formatter() function to create any_formatters more conveniently.
     template<typename T, typename Formatter>
     explicit any_formatter(T* dummy, const Formatter& formatter = Formatter())
-        : anyFormatter(new AnyFormatter<T, Formatter>(formatter))
+        : formatter(formatter)
+        , functions(formatter_functions<T, Formatter>::get_table())
     {
     }
 
     void save(TSerializer& serializer, const boost::any& object) const
     {
-        anyFormatter->save(serializer, object);
+        static_assert(detail::can_save_to<TSerializer>::value, "Can't save to a loading serializer.");
+        functions->save_any(formatter, serializer, object);
     }
 
     void load(TSerializer& serializer, boost::any& object) const
     {
-        anyFormatter->load(serializer, object);
+        static_assert(detail::can_load_from<TSerializer>::value, "Can't load from a saving serializer.");
+        functions->load_any(formatter, serializer, object);
+    }
+
+    /// @brief Saves the object directly, without wrapping it in boost::any.
+    template<typename T>
+    void save(TSerializer& serializer, const T& object) const
+    {
+        static_assert(detail::can_save_to<TSerializer>::value, "Can't save to a loading serializer.");
+        check_type<T>();
+        functions->save(formatter, serializer, &object);
     }
 
+    /// @brief Loads the object directly, without loading it into a boost::any first.
     template<typename T>
     void load(TSerializer& serializer, T& object) const
     {
-        boost::any any = T();
-        anyFormatter->load(serializer, any);
-        object = boost::any_cast<T>(any);
+        static_assert(detail::can_load_from<TSerializer>::value, "Can't load from a saving serializer.");
+        check_type<T>();
+        functions->load(formatter, serializer, &object);
     }
 
 private:
-    class IAnyFormatter
+    struct function_table
     {
-    public:
-        virtual ~IAnyFormatter() {}
-        virtual void save(TSerializer& serializer, const boost::any& object) const = 0;
-        virtual void load(TSerializer& serializer, boost::any& object) const = 0;
+        const void* value_type_tag;
+        void (*save)(const detail::erased_formatter_storage& formatter, TSerializer& serializer, const void* object);
+        void (*load)(const detail::erased_formatter_storage& formatter, TSerializer& serializer, void* object);
+        void (*save_any)(const detail::erased_formatter_storage& formatter, TSerializer& serializer, const boost::any& object);
+        void (*load_any)(const detail::erased_formatter_storage& formatter, TSerializer& serializer, boost::any& object);
     };
 
     template<typename T, typename Formatter>
-    class AnyFormatter : public IAnyFormatter
+    struct formatter_functions
     {
-    public:
-        explicit AnyFormatter(const Formatter& formatter = Formatter())
-            : formatter(formatter)
-        {}
+        static void save(const detail::erased_formatter_storage& formatter, TSerializer& serializer, const void* object)
+        {
+            formatter.template get<Formatter>().save(serializer, *static_cast<const T*>(object));
+        }
+
+        static void load(const detail::erased_formatter_storage& formatter, TSerializer& serializer, void* object)
+        {
+            formatter.template get<Formatter>().load(serializer, *static_cast<T*>(object));
+        }
 
-    public:
-        virtual void save(TSerializer& serializer, const boost::any& object) const
+        static void save_any(const detail::erased_formatter_storage& formatter, TSerializer& serializer, const boost::any& object)
         {
-            formatter.save(serializer, boost::any_cast<const T&>(object));
+            formatter.template get<Formatter>().save(serializer, boost::any_cast<const T&>(object));
         }
 
-        virtual void load(TSerializer& serializer, boost::any& object) const
+        static void load_any(const detail::erased_formatter_storage& formatter, TSerializer& serializer, boost::any& object)
         {
-            formatter.load(serializer, boost::any_cast<T&>(object));
+            formatter.template get<Formatter>().load(serializer, boost::any_cast<T&>(object));
         }
 
-    private:
-        Formatter formatter;
+        static decltype(&save) save_function(std::true_type)            { return &save; }
+        static decltype(&save) save_function(std::false_type)           { return nullptr; }
+        static decltype(&load) load_function(std::true_type)            { return &load; }
+        static decltype(&load) load_function(std::false_type)           { return nullptr; }
+        static decltype(&save_any) save_any_function(std::true_type)    { return &save_any; }
+        static decltype(&save_any) save_any_function(std::false_type)   { return nullptr; }
+        static decltype(&load_any) load_any_function(std::true_type)    { return &load_any; }
+        static decltype(&load_any) load_any_function(std::false_type)   { return nullptr; }
+
+        static const function_table* get_table()
+        {
+            static const function_table table = {
+                &type_tag<T>::id,
+                save_function(detail::can_save_to<TSerializer>()),
+                load_function(detail::can_load_from<TSerializer>()),
+                save_any_function(detail::can_save_to<TSerializer>()),
+                load_any_function(detail::can_load_from<TSerializer>()),
+            };
+            return &table;
+        }
     };
 
-    std::unique_ptr<IAnyFormatter> anyFormatter;
+    template<typename T>
+    void check_type() const
+    {
+        if (functions->value_type_tag != &type_tag<T>::id)
+        {
+            boost::throw_exception(boost::bad_any_cast());
+        }
+    }
+
+    detail::erased_formatter_storage formatter;
+    const function_table* functions;
 };
 
 template<typename TSerializer, typename T, typename Formatter>
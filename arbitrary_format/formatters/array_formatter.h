@@ -66,7 +66,7 @@ public:
         save_buffer(serializer, Size, array, value_formatter);
     }
 
-    template<int Size, typename ValueType, typename TSerializer>
+    template<size_t Size, typename ValueType, typename TSerializer>
     void save(TSerializer& serializer, const std::array<ValueType, Size>& array) const
     {
         save_buffer(serializer, Size, array.data(), value_formatter);
@@ -78,7 +78,7 @@ public:
         load_buffer(serializer, Size, array, value_formatter);
     }
 
-    template<int Size, typename ValueType, typename TSerializer>
+    template<size_t Size, typename ValueType, typename TSerializer>
     void load(TSerializer& serializer, std::array<ValueType, Size>& array) const
     {
         load_buffer(serializer, Size, array.data(), value_formatter);
@@ -101,7 +101,7 @@ template<typename ValueFormatter, int ArraySize, typename T>
 struct declare_verbatim_formatter< array_formatter<ValueFormatter, -1>, T[ArraySize] > : public is_verbatim_formatter<ValueFormatter, typename std::remove_pointer<typename std::decay<T>::type>::type>
 {};
 
-template<typename ValueFormatter, int ArraySize, typename T>
+template<typename ValueFormatter, size_t ArraySize, typename T>
 struct declare_verbatim_formatter< array_formatter<ValueFormatter, -1>, std::array<T, ArraySize> > : public is_verbatim_formatter<ValueFormatter, typename std::remove_pointer<typename std::decay<T>::type>::type>
 {};
 
@@ -109,8 +109,10 @@ template<typename ValueFormatter, int ArraySize, typename T>
 struct declare_verbatim_formatter< array_formatter<ValueFormatter, ArraySize>, T[ArraySize] > : public is_verbatim_formatter<ValueFormatter, typename std::remove_pointer<typename std::decay<T>::type>::type>
 {};
 
-template<typename ValueFormatter, int ArraySize, typename T>
-struct declare_verbatim_formatter< array_formatter<ValueFormatter, ArraySize>, std::array<T, ArraySize> > : public is_verbatim_formatter<ValueFormatter, typename std::remove_pointer<typename std::decay<T>::type>::type>
+/// @note std::array size is a size_t, so it can't be matched against int ArraySize directly.
+template<typename ValueFormatter, int ArraySize, size_t StdArraySize, typename T>
+struct declare_verbatim_formatter< array_formatter<ValueFormatter, ArraySize>, std::array<T, StdArraySize> >
+    : public std::integral_constant<bool, (ArraySize == static_cast<int>(StdArraySize)) && is_verbatim_formatter<ValueFormatter, typename std::remove_pointer<typename std::decay<T>::type>::type>::value>
 {};
 
 static_assert(is_verbatim_formatter< array_formatter< verbatim_formatter<2>, 10 >, uint16_t[10] >::value, "array_formatter<verbatim formatter> should be a verbatim formatter.");
@@ -7,6 +7,10 @@
 /// This file contains collection_formatter that formats collections, such as std::map, vector, set etc. as a length field followed by values.
 /// Collection type needs to have the following members:
 ///   begin(), end(), size(), clear(), insert(iterator, value), value_type
+/// If the collection has reserve(size) method, it is used before loading elements.
+/// collection_loader can be specialized for collections that can be loaded more efficiently than by inserting elements one by one.
+/// See flat_collection_loader.h for such specializations for boost::container flat containers.
+/// They are declared here, so all translation units agree on which loader is used; flat_collection_loader.h must be included to load flat containers.
 /// For std::vector a more optimized formatter is available: vector_formatter
 ///
 /// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
@@ -17,10 +21,17 @@
 #ifndef ArbitraryFormatSerializer_collection_formatter_H
 #define ArbitraryFormatSerializer_collection_formatter_H
 
+#include <arbitrary_format/utility/uses_allocator_construction.h>
+
+#include <cstddef>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <utility>
 
+#include <boost/container/container_fwd.hpp>
+#include <boost/version.hpp>
+
 namespace arbitrary_format
 {
 
@@ -32,18 +43,135 @@ struct collection_mutable_value_type
     using type = typename Collection::value_type;
 };
 
-template<typename KeyType, typename ValueType>
-struct collection_mutable_value_type< std::map<KeyType, ValueType> >
+template<typename KeyType, typename ValueType, typename Compare, typename Allocator>
+struct collection_mutable_value_type< std::map<KeyType, ValueType, Compare, Allocator> >
 {
     using type = std::pair<KeyType, ValueType>;
 };
 
-template<typename KeyType, typename ValueType>
-struct collection_mutable_value_type< std::multimap<KeyType, ValueType> >
+template<typename KeyType, typename ValueType, typename Compare, typename Allocator>
+struct collection_mutable_value_type< std::multimap<KeyType, ValueType, Compare, Allocator> >
 {
     using type = std::pair<KeyType, ValueType>;
 };
 
+template<typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Allocator>
+struct collection_mutable_value_type< std::unordered_map<KeyType, ValueType, Hash, KeyEqual, Allocator> >
+{
+    using type = std::pair<KeyType, ValueType>;
+};
+
+template<typename KeyType, typename ValueType, typename Hash, typename KeyEqual, typename Allocator>
+struct collection_mutable_value_type< std::unordered_multimap<KeyType, ValueType, Hash, KeyEqual, Allocator> >
+{
+    using type = std::pair<KeyType, ValueType>;
+};
+
+namespace detail
+{
+
+/// @brief Unordered containers may shrink their bucket array on reserve(), so it's called only if the buckets are too few.
+///        This way reloading a container doesn't rebuild its bucket array.
+template<typename Collection>
+auto reserve_no_shrink(Collection& collection, size_t size, int) -> decltype(void(collection.bucket_count()))
+{
+    if (size > collection.bucket_count() * collection.max_load_factor())
+    {
+        collection.reserve(size);
+    }
+}
+
+template<typename Collection>
+void reserve_no_shrink(Collection& collection, size_t size, long)
+{
+    collection.reserve(size);
+}
+
+/// @brief Calls collection.reserve(size) if the collection has such method (std::vector, std::unordered_map etc.), does nothing otherwise.
+template<typename Collection, typename Enable = void>
+struct collection_reserve
+{
+    static void reserve(Collection&, size_t)
+    {
+    }
+};
+
+template<typename Collection>
+struct collection_reserve< Collection, decltype( void(std::declval<Collection&>().reserve(std::declval<size_t>())) ) >
+{
+    static void reserve(Collection& collection, size_t size)
+    {
+        reserve_no_shrink(collection, size, 0);
+    }
+};
+
+/// @brief Default-constructs a mutable value of the collection, using collection's allocator if it has one.
+///        This way values of collections using std::pmr (or other stateful) allocators are loaded into memory from the right resource,
+///        and moving them into the collection doesn't reallocate them.
+template<typename Collection, typename Enable = void>
+struct collection_value
+{
+    using type = typename collection_mutable_value_type<Collection>::type;
+
+    static type make(const Collection&)
+    {
+        return type();
+    }
+};
+
+template<typename Collection>
+struct collection_value< Collection, decltype( void(std::declval<const Collection&>().get_allocator()) ) >
+{
+    using type = typename collection_mutable_value_type<Collection>::type;
+
+    static type make(const Collection& collection)
+    {
+        return make_using_allocator<type>(collection.get_allocator());
+    }
+};
+
+} // namespace detail
+
+/// @brief collection_loader loads given number of elements into a collection, replacing its previous contents.
+///        This default implementation clears the collection, reserves space if possible (which pre-sizes buckets of unordered containers),
+///        and move-inserts loaded values (constructed with collection's allocator) with end() as a hint, so loading sorted data into std::map or std::set takes linear time.
+/// @note  Last type parameter is to allow for enable_if usage in specializations.
+template<typename Collection, typename Enable = void>
+struct collection_loader
+{
+    template<typename TSerializer, typename ValueFormatter>
+    static void load(TSerializer& serializer, Collection& collection, size_t collection_size, const ValueFormatter& value_formatter)
+    {
+        collection.clear();
+        detail::collection_reserve<Collection>::reserve(collection, collection_size);
+        for (size_t i = 0; i < collection_size; ++i)
+        {
+            auto value = detail::collection_value<Collection>::make(collection);
+            value_formatter.load(serializer, value);
+            collection.insert(collection.end(), std::move(value));
+        }
+    }
+};
+
+#if BOOST_VERSION >= 106600
+
+/// @brief Loaders of boost::container flat containers. They are defined in flat_collection_loader.h.
+///        Declaring them here means that loading a flat container without including that header fails to compile,
+///        instead of using the generic loader in some translation units, and the specialization in others.
+template<typename KeyType, typename ValueType, typename Compare, typename AllocatorOrContainer>
+struct collection_loader< boost::container::flat_map<KeyType, ValueType, Compare, AllocatorOrContainer> >;
+
+template<typename KeyType, typename ValueType, typename Compare, typename AllocatorOrContainer>
+struct collection_loader< boost::container::flat_multimap<KeyType, ValueType, Compare, AllocatorOrContainer> >;
+
+template<typename KeyType, typename Compare, typename AllocatorOrContainer>
+struct collection_loader< boost::container::flat_set<KeyType, Compare, AllocatorOrContainer> >;
+
+template<typename KeyType, typename Compare, typename AllocatorOrContainer>
+struct collection_loader< boost::container::flat_multiset<KeyType, Compare, AllocatorOrContainer> >;
+
+#endif
+
 template<typename SizeFormatter, typename ValueFormatter>
 class collection_formatter
 {
@@ -67,18 +195,13 @@ public:
         }
     }
 
+    /// @note Elements are loaded by collection_loader<Collection>.
     template<typename Collection, typename TSerializer>
     void load(TSerializer& serializer, Collection& collection) const
     {
-        collection.clear();
         size_t collection_size;
         size_formatter.load(serializer, collection_size);
-        for (size_t i = 0; i < collection_size; ++i)
-        {
-            typename collection_mutable_value_type<Collection>::type value;
-            value_formatter.load(serializer, value);
-            collection.insert(collection.end(), value);
-        }
+        collection_loader<Collection>::load(serializer, collection, collection_size, value_formatter);
     }
 };
 
@@ -72,7 +72,7 @@ public:
     template<typename ValueType, typename TSerializer>
     void load(TSerializer& serializer, const ValueType& expected_value) const
     {
-        typename std::remove_cv<ValueType>::type loaded_value;
+        typename std::remove_cv<ValueType>::type loaded_value{};
         value_formatter.load(serializer, loaded_value);
         if (!detail::const_formatter_equals(loaded_value, expected_value))
         {
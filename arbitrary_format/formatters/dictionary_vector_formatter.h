@@ -0,0 +1,112 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// dictionary_vector_formatter.h
+///
+/// This file contains dictionary_vector_formatter that formats std::vector as a dictionary of distinct values followed by indices into that dictionary.
+/// It is meant for vectors with few distinct values (enums, status strings etc.), where each value is stored only once.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_dictionary_vector_formatter_H
+#define ArbitraryFormatSerializer_dictionary_vector_formatter_H
+
+#include <arbitrary_format/serialization_exceptions.h>
+#include <arbitrary_format/formatters/serialize_buffer.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace arbitrary_format
+{
+
+/// @brief dictionary_vector_formatter stores a vector as:
+///          - number of distinct values (SizeFormatter),
+///          - distinct values in order of their first occurrence (ValueFormatter),
+///          - number of elements (SizeFormatter),
+///          - index into the dictionary for every element (IndexFormatter).
+///        Value type must be usable as a key of std::unordered_map.
+template<typename SizeFormatter, typename ValueFormatter, typename IndexFormatter>
+class dictionary_vector_formatter
+{
+    SizeFormatter size_formatter;
+    ValueFormatter value_formatter;
+    IndexFormatter index_formatter;
+
+public:
+    dictionary_vector_formatter(SizeFormatter size_formatter = SizeFormatter(), ValueFormatter value_formatter = ValueFormatter(), IndexFormatter index_formatter = IndexFormatter())
+        : size_formatter(size_formatter)
+        , value_formatter(value_formatter)
+        , index_formatter(index_formatter)
+    {
+    }
+
+    template<typename ValueType, typename TSerializer>
+    void save(TSerializer& serializer, const std::vector<ValueType>& vector) const
+    {
+        std::unordered_map<ValueType, size_t> dictionary_indices;
+        std::vector<const ValueType*> dictionary;
+        std::vector<size_t> indices;
+        indices.reserve(vector.size());
+
+        for (auto& value : vector)
+        {
+            auto inserted = dictionary_indices.insert(std::make_pair(value, dictionary.size()));
+            if (inserted.second)
+            {
+                dictionary.push_back(&value);
+            }
+            indices.push_back(inserted.first->second);
+        }
+
+        size_formatter.save(serializer, dictionary.size());
+        for (auto value : dictionary)
+        {
+            value_formatter.save(serializer, *value);
+        }
+
+        size_formatter.save(serializer, indices.size());
+        save_buffer(serializer, indices.size(), indices.data(), index_formatter);
+    }
+
+    /// @brief Throws invalid_data if any of the indices is outside of the dictionary.
+    template<typename ValueType, typename TSerializer>
+    void load(TSerializer& serializer, std::vector<ValueType>& vector) const
+    {
+        size_t dictionary_size;
+        size_formatter.load(serializer, dictionary_size);
+
+        std::vector<ValueType> dictionary(dictionary_size);
+        load_buffer(serializer, dictionary_size, dictionary.data(), value_formatter);
+
+        size_t vector_size;
+        size_formatter.load(serializer, vector_size);
+
+        vector.clear();
+        vector.reserve(vector_size);
+        for (size_t i = 0; i < vector_size; ++i)
+        {
+            size_t index;
+            index_formatter.load(serializer, index);
+            if (index >= dictionary_size)
+            {
+                BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Dictionary index out of range."));
+            }
+            vector.push_back(dictionary[index]);
+        }
+    }
+};
+
+template<typename SizeFormatter, typename ValueFormatter, typename IndexFormatter>
+dictionary_vector_formatter<SizeFormatter, ValueFormatter, IndexFormatter> create_dictionary_vector_formatter(SizeFormatter size_formatter = SizeFormatter(), ValueFormatter value_formatter = ValueFormatter(), IndexFormatter index_formatter = IndexFormatter())
+{
+    return dictionary_vector_formatter<SizeFormatter, ValueFormatter, IndexFormatter>(size_formatter, value_formatter, index_formatter);
+}
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_dictionary_vector_formatter_H
@@ -0,0 +1,114 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// flat_collection_loader.h
+///
+/// This file contains collection_loader specializations for boost::container::flat_map, flat_multimap, flat_set and flat_multiset.
+/// Include it to load flat containers with collection_formatter (or map_formatter). The specializations are declared in collection_formatter.h,
+/// so loading a flat container without including this header doesn't compile.
+/// Elements are appended to the underlying sequence, which is sorted once at the end (if it's not sorted already).
+/// Requires Boost 1.66 or newer, for extract_sequence() and adopt_sequence().
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_flat_collection_loader_H
+#define ArbitraryFormatSerializer_flat_collection_loader_H
+
+#include <arbitrary_format/formatters/collection_formatter.h>
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include <boost/container/flat_map.hpp>
+#include <boost/container/flat_set.hpp>
+#include <boost/version.hpp>
+
+#if BOOST_VERSION < 106600
+#error "flat_collection_loader.h requires Boost 1.66 or newer."
+#endif
+
+namespace arbitrary_format
+{
+
+namespace detail
+{
+
+/// @brief Loads all elements into the collection's sequence, then sorts it (stable sort, so equal keys of multi-containers keep their order).
+///        Throws invalid_data if a unique collection would get duplicate keys.
+/// @note  Capacity of the collection's sequence is reused.
+template<bool Unique>
+struct flat_collection_loader
+{
+    template<typename Collection, typename TSerializer, typename ValueFormatter>
+    static void load(TSerializer& serializer, Collection& collection, size_t collection_size, const ValueFormatter& value_formatter)
+    {
+        auto sequence = collection.extract_sequence();
+        sequence.clear();
+        sequence.reserve(collection_size);
+        for (size_t i = 0; i < collection_size; ++i)
+        {
+            auto value = collection_value<Collection>::make(collection);
+            value_formatter.load(serializer, value);
+            sequence.push_back(std::move(value));
+        }
+
+        auto compare = collection.value_comp();
+        if (!std::is_sorted(sequence.begin(), sequence.end(), compare))
+        {
+            std::stable_sort(sequence.begin(), sequence.end(), compare);
+        }
+
+        adopt(collection, std::move(sequence), std::integral_constant<bool, Unique>());
+    }
+
+private:
+    template<typename Collection, typename Sequence>
+    static void adopt(Collection& collection, Sequence&& sequence, std::true_type)
+    {
+        auto compare = collection.value_comp();
+        auto duplicate = std::adjacent_find(sequence.begin(), sequence.end(), [&compare](const typename Collection::value_type& left, const typename Collection::value_type& right)
+        {
+            return !compare(left, right);
+        });
+        if (duplicate != sequence.end())
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Duplicate keys in a unique collection."));
+        }
+
+        collection.adopt_sequence(boost::container::ordered_unique_range, std::move(sequence));
+    }
+
+    template<typename Collection, typename Sequence>
+    static void adopt(Collection& collection, Sequence&& sequence, std::false_type)
+    {
+        collection.adopt_sequence(boost::container::ordered_range, std::move(sequence));
+    }
+};
+
+} // namespace detail
+
+template<typename KeyType, typename ValueType, typename Compare, typename AllocatorOrContainer>
+struct collection_loader< boost::container::flat_map<KeyType, ValueType, Compare, AllocatorOrContainer> > : public detail::flat_collection_loader<true>
+{};
+
+template<typename KeyType, typename ValueType, typename Compare, typename AllocatorOrContainer>
+struct collection_loader< boost::container::flat_multimap<KeyType, ValueType, Compare, AllocatorOrContainer> > : public detail::flat_collection_loader<false>
+{};
+
+template<typename KeyType, typename Compare, typename AllocatorOrContainer>
+struct collection_loader< boost::container::flat_set<KeyType, Compare, AllocatorOrContainer> > : public detail::flat_collection_loader<true>
+{};
+
+template<typename KeyType, typename Compare, typename AllocatorOrContainer>
+struct collection_loader< boost::container::flat_multiset<KeyType, Compare, AllocatorOrContainer> > : public detail::flat_collection_loader<false>
+{};
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_flat_collection_loader_H
@@ -0,0 +1,221 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// polymorphic_formatter.h
+///
+/// This file contains polymorphic_formatter that formats std::unique_ptr and std::shared_ptr to polymorphic objects,
+/// as a type tag followed by the object formatted with a formatter registered for its dynamic type.
+/// Types, their tags and formatters are registered in a polymorphic_registry.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_polymorphic_formatter_H
+#define ArbitraryFormatSerializer_polymorphic_formatter_H
+
+#include <arbitrary_format/serialization_exceptions.h>
+#include <arbitrary_format/utility/small_buffer_storage.h>
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace arbitrary_format
+{
+
+/// @brief polymorphic_registry maps classes derived from Base to their tags and formatters.
+///        Formatters are type erased, so they are bound to one saving serializer type and one loading serializer type.
+///        Lookups are done in a hash table keyed by address of type_info (on save), and in a vector indexed by tag (on load),
+///        so tags should be small numbers. Tag 0 is reserved for null pointers.
+/// @note  Register all types before the registry is used. Registration is not thread safe.
+template<typename Base, typename TSaveSerializer, typename TLoadSerializer>
+class polymorphic_registry
+{
+    static_assert(std::is_polymorphic<Base>::value, "polymorphic_registry requires a polymorphic base class.");
+
+public:
+    struct entry
+    {
+        size_t tag;
+        small_buffer_storage<> formatter;
+        void (*save)(const small_buffer_storage<>& formatter, TSaveSerializer& serializer, const Base& object);
+        void (*load_unique)(const small_buffer_storage<>& formatter, TLoadSerializer& serializer, std::unique_ptr<Base>& object);
+        void (*load_shared)(const small_buffer_storage<>& formatter, TLoadSerializer& serializer, std::shared_ptr<Base>& object);
+    };
+
+    /// @brief Registers Derived class under given tag, to be formatted with given formatter.
+    ///        Throws serialization_exception if the tag or type is already registered.
+    template<typename Derived, typename Formatter>
+    void register_type(size_t tag, const Formatter& formatter = Formatter())
+    {
+        static_assert(std::is_base_of<Base, Derived>::value, "Only classes derived from Base can be registered.");
+
+        if (tag == 0)
+        {
+            BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("Tag 0 is reserved for null pointers."));
+        }
+        if ((tag < tag_to_entry.size()) && (tag_to_entry[tag] != no_entry))
+        {
+            BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("Tag is already registered."));
+        }
+        if (type_to_entry.count(&typeid(Derived)) != 0)
+        {
+            BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("Type is already registered."));
+        }
+
+        entries.push_back(entry{ tag, small_buffer_storage<>(formatter), &save_derived<Derived, Formatter>, &load_unique_derived<Derived, Formatter>, &load_shared_derived<Derived, Formatter> });
+        if (tag >= tag_to_entry.size())
+        {
+            tag_to_entry.resize(tag + 1, no_entry);
+        }
+        tag_to_entry[tag] = entries.size() - 1;
+        type_to_entry[&typeid(Derived)] = entries.size() - 1;
+    }
+
+    /// @brief Returns entry of given dynamic type.
+    ///        Throws lossy_conversion if the type is not registered.
+    const entry& find_type(const std::type_info& type) const
+    {
+        auto found = type_to_entry.find(&type);
+        if (found == type_to_entry.end())
+        {
+            /// @note Type_info objects of the same type can have different addresses (if they come from different shared libraries).
+            for (auto& type_entry : type_to_entry)
+            {
+                if (*type_entry.first == type)
+                {
+                    return entries[type_entry.second];
+                }
+            }
+            BOOST_THROW_EXCEPTION(lossy_conversion() << errinfo_description("Type is not registered in polymorphic_registry."));
+        }
+        return entries[found->second];
+    }
+
+    /// @brief Returns entry of given tag.
+    ///        Throws invalid_data if the tag is not registered.
+    const entry& find_tag(size_t tag) const
+    {
+        if ((tag >= tag_to_entry.size()) || (tag_to_entry[tag] == no_entry))
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Tag is not registered in polymorphic_registry."));
+        }
+        return entries[tag_to_entry[tag]];
+    }
+
+private:
+    static const size_t no_entry = static_cast<size_t>(-1);
+
+    template<typename Derived, typename Formatter>
+    static void save_derived(const small_buffer_storage<>& formatter, TSaveSerializer& serializer, const Base& object)
+    {
+        formatter.template get<Formatter>().save(serializer, static_cast<const Derived&>(object));
+    }
+
+    template<typename Derived, typename Formatter>
+    static void load_unique_derived(const small_buffer_storage<>& formatter, TLoadSerializer& serializer, std::unique_ptr<Base>& object)
+    {
+        std::unique_ptr<Derived> loaded(new Derived());
+        formatter.template get<Formatter>().load(serializer, *loaded);
+        object = std::move(loaded);
+    }
+
+    template<typename Derived, typename Formatter>
+    static void load_shared_derived(const small_buffer_storage<>& formatter, TLoadSerializer& serializer, std::shared_ptr<Base>& object)
+    {
+        auto loaded = std::make_shared<Derived>();
+        formatter.template get<Formatter>().load(serializer, *loaded);
+        object = std::move(loaded);
+    }
+
+    std::vector<entry> entries;
+    std::vector<size_t> tag_to_entry;
+    std::unordered_map<const std::type_info*, size_t> type_to_entry;
+};
+
+template<typename Base, typename TSaveSerializer, typename TLoadSerializer>
+const size_t polymorphic_registry<Base, TSaveSerializer, TLoadSerializer>::no_entry;
+
+/// @brief polymorphic_formatter stores a pointer to a polymorphic object as its tag, formatted with TagFormatter, followed by the object,
+///        formatted with the formatter registered for its dynamic type. Null pointers are stored as tag 0.
+template<typename TagFormatter, typename Base, typename TSaveSerializer, typename TLoadSerializer>
+class polymorphic_formatter
+{
+    using registry_type = polymorphic_registry<Base, TSaveSerializer, TLoadSerializer>;
+
+    const registry_type& registry;
+    TagFormatter tag_formatter;
+
+public:
+    explicit polymorphic_formatter(const registry_type& registry, TagFormatter tag_formatter = TagFormatter())
+        : registry(registry)
+        , tag_formatter(tag_formatter)
+    {
+    }
+
+    template<typename Pointer>
+    void save(TSaveSerializer& serializer, const Pointer& value) const
+    {
+        if (!value)
+        {
+            tag_formatter.save(serializer, size_t(0));
+            return;
+        }
+
+        const Base& object = *value;
+        const auto& type_entry = registry.find_type(typeid(object));
+        tag_formatter.save(serializer, type_entry.tag);
+        type_entry.save(type_entry.formatter, serializer, object);
+    }
+
+    void load(TLoadSerializer& serializer, std::unique_ptr<Base>& value) const
+    {
+        const auto* tag_entry = load_tag(serializer);
+        if (tag_entry)
+        {
+            tag_entry->load_unique(tag_entry->formatter, serializer, value);
+        }
+        else
+        {
+            value.reset();
+        }
+    }
+
+    void load(TLoadSerializer& serializer, std::shared_ptr<Base>& value) const
+    {
+        const auto* tag_entry = load_tag(serializer);
+        if (tag_entry)
+        {
+            tag_entry->load_shared(tag_entry->formatter, serializer, value);
+        }
+        else
+        {
+            value.reset();
+        }
+    }
+
+private:
+    /// @brief Returns entry of loaded tag, or nullptr for null pointers.
+    const typename registry_type::entry* load_tag(TLoadSerializer& serializer) const
+    {
+        size_t tag;
+        tag_formatter.load(serializer, tag);
+        return (tag == 0) ? nullptr : &registry.find_tag(tag);
+    }
+};
+
+template<typename TagFormatter, typename Base, typename TSaveSerializer, typename TLoadSerializer>
+polymorphic_formatter<TagFormatter, Base, TSaveSerializer, TLoadSerializer> create_polymorphic_formatter(const polymorphic_registry<Base, TSaveSerializer, TLoadSerializer>& registry, TagFormatter tag_formatter = TagFormatter())
+{
+    return polymorphic_formatter<TagFormatter, Base, TSaveSerializer, TLoadSerializer>(registry, tag_formatter);
+}
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_polymorphic_formatter_H
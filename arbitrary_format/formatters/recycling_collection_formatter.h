@@ -0,0 +1,236 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// recycling_collection_formatter.h
+///
+/// This file contains recycling_collection_formatter and recycling_map_formatter.
+/// They format collections the same way as collection_formatter and map_formatter do,
+/// but when loading into a node-based container (std::map, std::set, std::unordered_map...) they reuse its existing nodes.
+/// Elements are loaded into the recycled nodes, so their storage (like string capacity) is reused too.
+/// Reloading a container with the same number of elements then doesn't allocate or free any nodes.
+/// Node recycling uses C++17 node extraction. Without it, associative containers must use pool_allocator:
+/// nodes freed by clear() go to the pool's free lists, and are taken from there by inserts (element storage is not reused then).
+/// Other collections (like std::vector, that keeps its capacity anyway) are loaded with collection_loader.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_recycling_collection_formatter_H
+#define ArbitraryFormatSerializer_recycling_collection_formatter_H
+
+#include <arbitrary_format/formatters/collection_formatter.h>
+#include <arbitrary_format/formatters/pair_formatter.h>
+#include <arbitrary_format/utility/pool_allocator.h>
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace arbitrary_format
+{
+
+namespace detail
+{
+
+template<typename Collection, typename Enable = void>
+struct has_capacity : public std::false_type
+{};
+
+template<typename Collection>
+struct has_capacity< Collection, decltype( void(std::declval<const Collection&>().capacity()) ) > : public std::true_type
+{};
+
+/// @brief True for associative containers that allocate a node per element (std::map, std::set, std::unordered_map...).
+///        Flat containers have capacity(), and keep their storage on clear() anyway.
+template<typename Collection, typename Enable = void>
+struct is_node_based_collection : public std::false_type
+{};
+
+template<typename Collection>
+struct is_node_based_collection< Collection, decltype( void(std::declval<typename Collection::key_type>()) ) >
+    : public std::integral_constant<bool, !has_capacity<Collection>::value>
+{};
+
+template<typename Allocator>
+struct is_pool_allocator : public std::false_type
+{};
+
+template<typename T>
+struct is_pool_allocator< pool_allocator<T> > : public std::true_type
+{};
+
+template<typename Collection, typename Enable = void>
+struct uses_pool_allocator : public std::false_type
+{};
+
+template<typename Collection>
+struct uses_pool_allocator< Collection, decltype( void(std::declval<typename Collection::allocator_type>()) ) >
+    : public is_pool_allocator<typename Collection::allocator_type>
+{};
+
+} // namespace detail
+
+/// @brief recycling_collection_loader loads elements into nodes extracted from the collection's previous contents.
+///        Nodes that are left over are freed, missing ones are allocated.
+///        Without node extraction associative containers are recycled only through pool_allocator's free lists,
+///        and using other allocators with them is a compile error, instead of a silent fallback to plain loading.
+/// @note  Last type parameter is to allow for enable_if usage in specializations.
+template<typename Collection, typename Enable = void>
+struct recycling_collection_loader : public collection_loader<Collection>
+{
+    static_assert(!detail::is_node_based_collection<Collection>::value || detail::uses_pool_allocator<Collection>::value,
+                  "Recycling nodes of this collection requires C++17 node extraction, or pool_allocator as the collection's allocator.");
+};
+
+#ifdef __cpp_lib_node_extract
+
+namespace detail
+{
+
+template<typename Node, typename Enable = void>
+struct recycled_node_value
+{
+    template<typename TSerializer, typename ValueFormatter>
+    static void load(TSerializer& serializer, Node& node, const ValueFormatter& value_formatter)
+    {
+        value_formatter.load(serializer, node.value());
+    }
+};
+
+/// @brief Map nodes are loaded through a pair of references to their key and mapped value.
+template<typename Node>
+struct recycled_node_value< Node, decltype( void(std::declval<Node&>().mapped()) ) >
+{
+    template<typename TSerializer, typename ValueFormatter>
+    static void load(TSerializer& serializer, Node& node, const ValueFormatter& value_formatter)
+    {
+        std::pair<typename Node::key_type&, typename Node::mapped_type&> value(node.key(), node.mapped());
+        value_formatter.load(serializer, value);
+    }
+};
+
+template<typename Collection, typename ValueFormatter, typename TSerializer>
+void load_recycled_element(TSerializer& serializer, Collection& collection, typename Collection::node_type* node, const ValueFormatter& value_formatter)
+{
+    if (node == nullptr)
+    {
+        auto value = collection_value<Collection>::make(collection);
+        value_formatter.load(serializer, value);
+        collection.insert(collection.end(), std::move(value));
+    }
+    else
+    {
+        recycled_node_value<typename Collection::node_type>::load(serializer, *node, value_formatter);
+        collection.insert(collection.end(), std::move(*node));
+    }
+}
+
+/// @brief Ordered containers: old nodes are moved out with the whole tree, which doesn't allocate.
+template<typename Collection, typename Enable = void>
+struct recycle_nodes
+{
+    template<typename TSerializer, typename ValueFormatter>
+    static void load(TSerializer& serializer, Collection& collection, size_t collection_size, const ValueFormatter& value_formatter)
+    {
+        Collection old_collection(std::move(collection));
+        collection.clear();
+
+        for (size_t i = 0; i < collection_size; ++i)
+        {
+            if (old_collection.empty())
+            {
+                load_recycled_element(serializer, collection, nullptr, value_formatter);
+            }
+            else
+            {
+                auto node = old_collection.extract(old_collection.begin());
+                load_recycled_element(serializer, collection, &node, value_formatter);
+            }
+        }
+    }
+};
+
+/// @brief Unordered containers: old nodes are extracted in place, so the collection keeps its bucket array,
+///        and reserve() doesn't rebuild it when the size didn't grow.
+template<typename Collection>
+struct recycle_nodes< Collection, decltype( void(std::declval<const Collection&>().bucket_count()) ) >
+{
+    template<typename TSerializer, typename ValueFormatter>
+    static void load(TSerializer& serializer, Collection& collection, size_t collection_size, const ValueFormatter& value_formatter)
+    {
+        std::vector<typename Collection::node_type> old_nodes;
+        old_nodes.reserve(std::min(collection.size(), collection_size));
+        while (old_nodes.size() < collection_size && !collection.empty())
+        {
+            old_nodes.push_back(collection.extract(collection.begin()));
+        }
+        collection.clear();
+        collection_reserve<Collection>::reserve(collection, collection_size);
+
+        for (size_t i = 0; i < collection_size; ++i)
+        {
+            load_recycled_element(serializer, collection, (i < old_nodes.size()) ? &old_nodes[i] : nullptr, value_formatter);
+        }
+    }
+};
+
+} // namespace detail
+
+template<typename Collection>
+struct recycling_collection_loader< Collection, decltype( void(std::declval<Collection&>().extract(std::declval<Collection&>().begin())) ) >
+    : public detail::recycle_nodes<Collection>
+{};
+
+#endif
+
+template<typename SizeFormatter, typename ValueFormatter>
+class recycling_collection_formatter
+{
+    SizeFormatter size_formatter;
+    ValueFormatter value_formatter;
+
+public:
+    recycling_collection_formatter(SizeFormatter size_formatter = SizeFormatter(), ValueFormatter value_formatter = ValueFormatter())
+        : size_formatter(size_formatter)
+        , value_formatter(value_formatter)
+    {
+    }
+
+    template<typename Collection, typename TSerializer>
+    void save(TSerializer& serializer, const Collection& collection) const
+    {
+        collection_formatter<SizeFormatter, ValueFormatter>(size_formatter, value_formatter).save(serializer, collection);
+    }
+
+    /// @note Elements are loaded by recycling_collection_loader<Collection>.
+    template<typename Collection, typename TSerializer>
+    void load(TSerializer& serializer, Collection& collection) const
+    {
+        size_t collection_size;
+        size_formatter.load(serializer, collection_size);
+        recycling_collection_loader<Collection>::load(serializer, collection, collection_size, value_formatter);
+    }
+};
+
+template<typename SizeFormatter, typename ValueFormatter>
+recycling_collection_formatter<SizeFormatter, ValueFormatter> create_recycling_collection_formatter(SizeFormatter size_formatter = SizeFormatter(), ValueFormatter value_formatter = ValueFormatter())
+{
+    return recycling_collection_formatter<SizeFormatter, ValueFormatter>(size_formatter, value_formatter);
+}
+
+template<typename SizeFormatter, typename KeyFormatter, typename ValueFormatter>
+using recycling_map_formatter = recycling_collection_formatter<SizeFormatter, pair_formatter<KeyFormatter, ValueFormatter>>;
+
+template<typename SizeFormatter, typename KeyFormatter, typename ValueFormatter>
+recycling_map_formatter<SizeFormatter, KeyFormatter, ValueFormatter> create_recycling_map_formatter(SizeFormatter size_formatter = SizeFormatter(), KeyFormatter key_formatter = KeyFormatter(), ValueFormatter value_formatter = ValueFormatter())
+{
+    return create_recycling_collection_formatter(size_formatter, create_pair_formatter(key_formatter, value_formatter));
+}
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_recycling_collection_formatter_H
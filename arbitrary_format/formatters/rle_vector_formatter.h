@@ -0,0 +1,96 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// rle_vector_formatter.h
+///
+/// This file contains rle_vector_formatter that formats std::vector as length field followed by runs of equal values (run-length encoding).
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_rle_vector_formatter_H
+#define ArbitraryFormatSerializer_rle_vector_formatter_H
+
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <vector>
+
+namespace arbitrary_format
+{
+
+/// @brief rle_vector_formatter stores a vector as number of elements (SizeFormatter),
+///        followed by a value (ValueFormatter) and a run length (RunLengthFormatter) for every run of equal consecutive elements.
+///        Values are compared using "==" operator.
+template<typename SizeFormatter, typename ValueFormatter, typename RunLengthFormatter>
+class rle_vector_formatter
+{
+    SizeFormatter size_formatter;
+    ValueFormatter value_formatter;
+    RunLengthFormatter run_length_formatter;
+
+public:
+    rle_vector_formatter(SizeFormatter size_formatter = SizeFormatter(), ValueFormatter value_formatter = ValueFormatter(), RunLengthFormatter run_length_formatter = RunLengthFormatter())
+        : size_formatter(size_formatter)
+        , value_formatter(value_formatter)
+        , run_length_formatter(run_length_formatter)
+    {
+    }
+
+    template<typename ValueType, typename TSerializer>
+    void save(TSerializer& serializer, const std::vector<ValueType>& vector) const
+    {
+        size_formatter.save(serializer, vector.size());
+
+        auto run_begin = vector.begin();
+        while (run_begin != vector.end())
+        {
+            auto run_end = run_begin + 1;
+            while ((run_end != vector.end()) && (*run_end == *run_begin))
+            {
+                ++run_end;
+            }
+
+            value_formatter.save(serializer, *run_begin);
+            run_length_formatter.save(serializer, static_cast<size_t>(run_end - run_begin));
+            run_begin = run_end;
+        }
+    }
+
+    /// @brief Throws invalid_data if a run is empty, or if runs don't sum up to the number of elements.
+    template<typename ValueType, typename TSerializer>
+    void load(TSerializer& serializer, std::vector<ValueType>& vector) const
+    {
+        size_t vector_size;
+        size_formatter.load(serializer, vector_size);
+
+        vector.clear();
+        vector.reserve(vector_size);
+        while (vector.size() < vector_size)
+        {
+            ValueType value;
+            value_formatter.load(serializer, value);
+
+            size_t run_length;
+            run_length_formatter.load(serializer, run_length);
+            if ((run_length == 0) || (run_length > vector_size - vector.size()))
+            {
+                BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Invalid run length."));
+            }
+
+            vector.insert(vector.end(), run_length, value);
+        }
+    }
+};
+
+template<typename SizeFormatter, typename ValueFormatter, typename RunLengthFormatter>
+rle_vector_formatter<SizeFormatter, ValueFormatter, RunLengthFormatter> create_rle_vector_formatter(SizeFormatter size_formatter = SizeFormatter(), ValueFormatter value_formatter = ValueFormatter(), RunLengthFormatter run_length_formatter = RunLengthFormatter())
+{
+    return rle_vector_formatter<SizeFormatter, ValueFormatter, RunLengthFormatter>(size_formatter, value_formatter, run_length_formatter);
+}
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_rle_vector_formatter_H
@@ -16,14 +16,31 @@
 #define ArbitraryFormatSerializer_buffer_formatter_H
 
 #include <arbitrary_format/binary_formatters/verbatim_formatter.h>
+#include <arbitrary_format/utility/default_init_allocator.h>
 
+#include <algorithm>
+#include <cstddef>
 #include <type_traits>
 
 namespace arbitrary_format
 {
 
+/// @brief declare_buffer_formatter type trait is intended to be specialized for formatters that can save and load whole buffers of given type
+///        faster than one value at a time. Such formatters must have following methods:
+///          template<typename TSerializer, typename SizeType> void save_buffer(TSerializer& serializer, SizeType size, const T* array) const;
+///          template<typename TSerializer, typename SizeType> void load_buffer(TSerializer& serializer, SizeType size, T* array) const;
+/// @note Verbatim formatters don't need this - they are always saved and loaded with a single call to saveData() / loadData().
+/// @note Last type parameter is to allow for enable_if usage in specializations.
+template<typename Formatter, typename T, typename = void>
+struct declare_buffer_formatter : public std::false_type
+{};
+
+/// @brief is_buffer_formatter is a true_type if formatter has save_buffer() and load_buffer() methods for given type.
+template<typename Formatter, typename T>
+using is_buffer_formatter = declare_buffer_formatter< typename std::remove_cv< typename std::remove_reference<Formatter>::type >::type, T >;
+
 template<typename ValueFormatter, typename ValueType, typename TSerializer, typename SizeType>
-typename std::enable_if< !binary::is_verbatim_formatter<ValueFormatter, ValueType>::value >::type 
+typename std::enable_if< !binary::is_verbatim_formatter<ValueFormatter, ValueType>::value && !is_buffer_formatter<ValueFormatter, ValueType>::value >::type 
 save_buffer(TSerializer& serializer, SizeType size, const ValueType *const array, ValueFormatter&& value_formatter)
 {
     for (SizeType i = 0; i < size; ++i)
@@ -32,6 +49,13 @@ save_buffer(TSerializer& serializer, SizeType size, const ValueType *const array
     }
 }
 
+template<typename ValueFormatter, typename ValueType, typename TSerializer, typename SizeType>
+typename std::enable_if< !binary::is_verbatim_formatter<ValueFormatter, ValueType>::value && is_buffer_formatter<ValueFormatter, ValueType>::value >::type 
+save_buffer(TSerializer& serializer, SizeType size, const ValueType *const array, ValueFormatter&& value_formatter)
+{
+    std::forward<ValueFormatter>(value_formatter).save_buffer(serializer, size, array);
+}
+
 template<typename ValueFormatter, typename ValueType, typename TSerializer, typename SizeType>
 typename std::enable_if< binary::is_verbatim_formatter<ValueFormatter, ValueType>::value >::type 
 save_buffer(TSerializer& serializer, SizeType size, const ValueType *const array, ValueFormatter&& value_formatter)
@@ -41,7 +65,7 @@ save_buffer(TSerializer& serializer, SizeType size, const ValueType *const array
 }
 
 template<typename ValueFormatter, typename ValueType, typename TSerializer, typename SizeType>
-typename std::enable_if< !binary::is_verbatim_formatter<ValueFormatter, ValueType>::value >::type 
+typename std::enable_if< !binary::is_verbatim_formatter<ValueFormatter, ValueType>::value && !is_buffer_formatter<ValueFormatter, ValueType>::value >::type 
 load_buffer(TSerializer& serializer, SizeType size, ValueType *const array, ValueFormatter&& value_formatter)
 {
     for (SizeType i = 0; i < size; ++i)
@@ -50,6 +74,13 @@ load_buffer(TSerializer& serializer, SizeType size, ValueType *const array, Valu
     }
 }
 
+template<typename ValueFormatter, typename ValueType, typename TSerializer, typename SizeType>
+typename std::enable_if< !binary::is_verbatim_formatter<ValueFormatter, ValueType>::value && is_buffer_formatter<ValueFormatter, ValueType>::value >::type 
+load_buffer(TSerializer& serializer, SizeType size, ValueType *const array, ValueFormatter&& value_formatter)
+{
+    std::forward<ValueFormatter>(value_formatter).load_buffer(serializer, size, array);
+}
+
 template<typename ValueFormatter, typename ValueType, typename TSerializer, typename SizeType>
 typename std::enable_if< binary::is_verbatim_formatter<ValueFormatter, ValueType>::value >::type 
 load_buffer(TSerializer& serializer, SizeType size, ValueType *const array, ValueFormatter&& value_formatter)
@@ -58,6 +89,61 @@ load_buffer(TSerializer& serializer, SizeType size, ValueType *const array, Valu
     serializer.loadData(reinterpret_cast<uint8_t*>(array), size * sizeof(ValueType));
 }
 
+namespace detail
+{
+
+template<typename Container>
+typename Container::value_type* sequence_data(Container& container)
+{
+    return container.empty() ? nullptr : &container[0];
+}
+
+template<typename ValueFormatter, typename Container, typename TSerializer>
+void load_sequence_resize(TSerializer& serializer, size_t size, Container& container, ValueFormatter&& value_formatter)
+{
+    container.resize(size);
+    load_buffer(serializer, size, sequence_data(container), std::forward<ValueFormatter>(value_formatter));
+}
+
+} // namespace detail
+
+/// @brief Replaces contents of a contiguous sequence (std::vector, std::basic_string) with size loaded values.
+///        Growing a sequence with resize() value-initializes (zero-fills) new elements, only for load_buffer() to overwrite them right after.
+///        So for values loaded verbatim the sequence is cleared instead, and values are appended in chunks through a small buffer.
+/// @note  Sequences with default_init_allocator are simply resized, as their resize() doesn't initialize elements.
+template<typename ValueFormatter, typename Container, typename TSerializer>
+typename std::enable_if< !binary::is_verbatim_formatter<ValueFormatter, typename Container::value_type>::value || is_default_init_allocator<typename Container::allocator_type>::value >::type
+load_sequence(TSerializer& serializer, size_t size, Container& container, ValueFormatter&& value_formatter)
+{
+    detail::load_sequence_resize(serializer, size, container, std::forward<ValueFormatter>(value_formatter));
+}
+
+template<typename ValueFormatter, typename Container, typename TSerializer>
+typename std::enable_if< binary::is_verbatim_formatter<ValueFormatter, typename Container::value_type>::value && !is_default_init_allocator<typename Container::allocator_type>::value >::type
+load_sequence(TSerializer& serializer, size_t size, Container& container, ValueFormatter&& value_formatter)
+{
+    using ValueType = typename Container::value_type;
+
+    if (size <= container.size())
+    {
+        // shrinking doesn't initialize anything
+        detail::load_sequence_resize(serializer, size, container, std::forward<ValueFormatter>(value_formatter));
+        return;
+    }
+
+    static const size_t chunk_size = (sizeof(ValueType) < 4096) ? 4096 / sizeof(ValueType) : 1;
+    ValueType buffer[chunk_size];
+
+    container.clear();
+    container.reserve(size);
+    for (size_t done = 0; done < size; done += chunk_size)
+    {
+        size_t count = std::min(chunk_size, size - done);
+        load_buffer(serializer, count, buffer, std::forward<ValueFormatter>(value_formatter));
+        container.insert(container.end(), buffer, buffer + count);
+    }
+}
+
 } // namespace arbitrary_format
 
 #endif // ArbitraryFormatSerializer_buffer_formatter_H
@@ -6,7 +6,8 @@
 ///
 /// This file contains shared_ptr_copy_formatter that formats std::shared_ptr as a flag field followed by the value.
 /// NOTE: Every instance of a shared_ptr will be serialized as an independent copy (so the shared ownership will NOT be preserved).
-/// NOTE: Upon loading operator new will be used to create new instance of the pointed object.
+/// NOTE: Upon loading std::allocate_shared will be used to create new instance of the pointed object, with given allocator (std::allocator by default).
+///       Use pool_allocator to allocate many small objects from a node_pool.
 ///
 /// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
 /// (c) 2014 Zbigniew Skowron, zbychs@gmail.com
@@ -17,20 +18,30 @@
 #define ArbitraryFormatSerializer_shared_ptr_copy_formatter_H
 
 #include <memory>
+#include <utility>
 
 namespace arbitrary_format
 {
 
-template<typename FlagFormatter, typename ValueFormatter>
+/// @brief Specifies when a loaded object is constructed in its final place.
+enum class pointee_construction
+{
+    before_load,    ///< Object is value-initialized in place, and then loaded.
+    after_load,     ///< Object is loaded into a local variable, and then move-constructed in place. Use it for objects that are cheap to move.
+};
+
+template<typename FlagFormatter, typename ValueFormatter, typename Allocator = std::allocator<char>, pointee_construction Construction = pointee_construction::before_load>
 class shared_ptr_copy_formatter
 {
     FlagFormatter flag_formatter;
     ValueFormatter value_formatter;
+    Allocator allocator;
 
 public:
-    shared_ptr_copy_formatter(FlagFormatter flag_formatter = FlagFormatter(), ValueFormatter value_formatter = ValueFormatter())
+    shared_ptr_copy_formatter(FlagFormatter flag_formatter = FlagFormatter(), ValueFormatter value_formatter = ValueFormatter(), Allocator allocator = Allocator())
         : flag_formatter(flag_formatter)
         , value_formatter(value_formatter)
+        , allocator(allocator)
     {
     }
 
@@ -44,6 +55,7 @@ public:
         }
     }
 
+    /// @note Object and shared_ptr's control block are allocated together, in one allocation.
     template<typename ValueType, typename TSerializer>
     void load(TSerializer& serializer, std::shared_ptr<ValueType>& value) const
     {
@@ -52,16 +64,42 @@ public:
         flag_formatter.load(serializer, value_flag);
         if (value_flag)
         {
-            value.reset(new ValueType());
-            value_formatter.load(serializer, *value);
+            value = load_value<ValueType>(serializer, std::integral_constant<pointee_construction, Construction>());
         }
     }
+
+private:
+    template<typename ValueType>
+    using value_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ValueType>;
+
+    template<typename ValueType, typename TSerializer>
+    std::shared_ptr<ValueType> load_value(TSerializer& serializer, std::integral_constant<pointee_construction, pointee_construction::before_load>) const
+    {
+        auto loaded = std::allocate_shared<ValueType>(value_allocator<ValueType>(allocator));
+        value_formatter.load(serializer, *loaded);
+        return loaded;
+    }
+
+    template<typename ValueType, typename TSerializer>
+    std::shared_ptr<ValueType> load_value(TSerializer& serializer, std::integral_constant<pointee_construction, pointee_construction::after_load>) const
+    {
+        ValueType loaded = ValueType();
+        value_formatter.load(serializer, loaded);
+        return std::allocate_shared<ValueType>(value_allocator<ValueType>(allocator), std::move(loaded));
+    }
 };
 
-template<typename FlagFormatter, typename ValueFormatter>
-shared_ptr_copy_formatter<FlagFormatter, ValueFormatter> create_shared_ptr_copy_formatter(FlagFormatter flag_formatter = FlagFormatter(), ValueFormatter value_formatter = ValueFormatter())
+template<typename FlagFormatter, typename ValueFormatter, typename Allocator = std::allocator<char>>
+shared_ptr_copy_formatter<FlagFormatter, ValueFormatter, Allocator> create_shared_ptr_copy_formatter(FlagFormatter flag_formatter = FlagFormatter(), ValueFormatter value_formatter = ValueFormatter(), Allocator allocator = Allocator())
+{
+    return shared_ptr_copy_formatter<FlagFormatter, ValueFormatter, Allocator>(flag_formatter, value_formatter, allocator);
+}
+
+/// @brief Use it like: create_shared_ptr_copy_formatter<pointee_construction::after_load>(flag_formatter, value_formatter, allocator)
+template<pointee_construction Construction, typename FlagFormatter, typename ValueFormatter, typename Allocator = std::allocator<char>>
+shared_ptr_copy_formatter<FlagFormatter, ValueFormatter, Allocator, Construction> create_shared_ptr_copy_formatter(FlagFormatter flag_formatter = FlagFormatter(), ValueFormatter value_formatter = ValueFormatter(), Allocator allocator = Allocator())
 {
-    return shared_ptr_copy_formatter<FlagFormatter, ValueFormatter>(flag_formatter, value_formatter);
+    return shared_ptr_copy_formatter<FlagFormatter, ValueFormatter, Allocator, Construction>(flag_formatter, value_formatter, allocator);
 }
 
 } // namespace arbitrary_format
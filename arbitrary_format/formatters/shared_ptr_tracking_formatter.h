@@ -0,0 +1,176 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// shared_ptr_tracking_formatter.h
+///
+/// This file contains shared_ptr_tracking_formatter that formats std::shared_ptr preserving shared ownership.
+/// Every distinct object is stored only once, and all further pointers to it are stored as back-references.
+/// Objects are tracked in a shared_ptr_tracking_context, that must be shared by all formatters of one save or load session.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_shared_ptr_tracking_formatter_H
+#define ArbitraryFormatSerializer_shared_ptr_tracking_formatter_H
+
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace arbitrary_format
+{
+
+/// @brief Table of objects already saved or loaded by shared_ptr_tracking_formatter.
+///        Objects get consecutive ids starting from 1, in order of their first occurrence.
+///        Use one context for saving or loading a whole stream; call clear() to start a new one.
+class shared_ptr_tracking_context
+{
+public:
+    /// @brief Returns id of given object, and whether it was seen for the first time.
+    ///        Objects are identified by address and type, so an object and its first member get different ids.
+    ///        Saved objects are kept alive until clear(), so their addresses can't be reused by other objects during the session.
+    std::pair<size_t, bool> register_saved(std::shared_ptr<const void> object, const std::type_info& type)
+    {
+        auto inserted = saved_ids.emplace(saved_key(object.get(), type), saved_ids.size() + 1);
+        if (inserted.second)
+        {
+            saved_objects.push_back(std::move(object));
+        }
+        return std::make_pair(inserted.first->second, inserted.second);
+    }
+
+    /// @brief Id that will be given to the next loaded object.
+    size_t next_loaded_id() const
+    {
+        return loaded_objects.size() + 1;
+    }
+
+    void register_loaded(std::shared_ptr<void> object, const std::type_info& type)
+    {
+        loaded_objects.emplace_back(std::move(object), std::type_index(type));
+    }
+
+    /// @brief Returns object with given id.
+    ///        Throws invalid_data if there is no such object, or if it's of a different type.
+    template<typename ValueType>
+    std::shared_ptr<ValueType> get_loaded(size_t id) const
+    {
+        if ((id == 0) || (id > loaded_objects.size()))
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Back-reference to an object that was not loaded yet."));
+        }
+
+        const auto& loaded = loaded_objects[id - 1];
+        if (loaded.second != std::type_index(typeid(ValueType)))
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Back-reference to an object of a different type."));
+        }
+        return std::static_pointer_cast<ValueType>(loaded.first);
+    }
+
+    void clear()
+    {
+        saved_ids.clear();
+        saved_objects.clear();
+        loaded_objects.clear();
+    }
+
+private:
+    using saved_key = std::pair<const void*, std::type_index>;
+
+    struct saved_key_hash
+    {
+        size_t operator()(const saved_key& key) const
+        {
+            return std::hash<const void*>()(key.first) ^ key.second.hash_code();
+        }
+    };
+
+    std::unordered_map<saved_key, size_t, saved_key_hash> saved_ids;
+    std::vector< std::shared_ptr<const void> > saved_objects;
+    std::vector< std::pair<std::shared_ptr<void>, std::type_index> > loaded_objects;
+};
+
+/// @brief shared_ptr_tracking_formatter stores a shared_ptr as an id, formatted with IdFormatter:
+///        0 for null, id of a new object followed by the object, or id of an object stored earlier.
+///        On load, pointers to the same id share ownership of one object.
+/// @note  Objects are registered before their values are saved or loaded, so cyclic references are supported.
+///        For that reason loaded objects are value-initialized with std::allocate_shared (using Allocator), and then loaded in place.
+template<typename IdFormatter, typename ValueFormatter, typename Allocator = std::allocator<char>>
+class shared_ptr_tracking_formatter
+{
+    shared_ptr_tracking_context& context;
+    IdFormatter id_formatter;
+    ValueFormatter value_formatter;
+    Allocator allocator;
+
+public:
+    explicit shared_ptr_tracking_formatter(shared_ptr_tracking_context& context, IdFormatter id_formatter = IdFormatter(), ValueFormatter value_formatter = ValueFormatter(), Allocator allocator = Allocator())
+        : context(context)
+        , id_formatter(id_formatter)
+        , value_formatter(value_formatter)
+        , allocator(allocator)
+    {
+    }
+
+    template<typename ValueType, typename TSerializer>
+    void save(TSerializer& serializer, const std::shared_ptr<ValueType>& value) const
+    {
+        if (!value)
+        {
+            id_formatter.save(serializer, size_t(0));
+            return;
+        }
+
+        auto id = context.register_saved(value, typeid(ValueType));
+        id_formatter.save(serializer, id.first);
+        if (id.second)
+        {
+            value_formatter.save(serializer, *value);
+        }
+    }
+
+    /// @note Throws invalid_data if loaded id is neither 0, nor an id of an already loaded object, nor the next id.
+    template<typename ValueType, typename TSerializer>
+    void load(TSerializer& serializer, std::shared_ptr<ValueType>& value) const
+    {
+        size_t id;
+        id_formatter.load(serializer, id);
+        if (id == 0)
+        {
+            value.reset();
+        }
+        else if (id == context.next_loaded_id())
+        {
+            using value_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ValueType>;
+            auto loaded = std::allocate_shared<ValueType>(value_allocator(allocator));
+            context.register_loaded(loaded, typeid(ValueType));
+            value = loaded;
+            value_formatter.load(serializer, *loaded);
+        }
+        else
+        {
+            value = context.get_loaded<ValueType>(id);
+        }
+    }
+};
+
+template<typename IdFormatter, typename ValueFormatter, typename Allocator = std::allocator<char>>
+shared_ptr_tracking_formatter<IdFormatter, ValueFormatter, Allocator> create_shared_ptr_tracking_formatter(shared_ptr_tracking_context& context, IdFormatter id_formatter = IdFormatter(), ValueFormatter value_formatter = ValueFormatter(), Allocator allocator = Allocator())
+{
+    return shared_ptr_tracking_formatter<IdFormatter, ValueFormatter, Allocator>(context, id_formatter, value_formatter, allocator);
+}
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_shared_ptr_tracking_formatter_H
@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// sparse_vector_formatter.h
+///
+/// This file contains sparse_vector_formatter that formats std::vector as length field followed by (index, value) pairs of elements that are different from default value.
+/// It is meant for vectors where most elements are zeros (or other default-constructed values).
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_sparse_vector_formatter_H
+#define ArbitraryFormatSerializer_sparse_vector_formatter_H
+
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <vector>
+
+namespace arbitrary_format
+{
+
+/// @brief sparse_vector_formatter stores a vector as:
+///          - number of elements (SizeFormatter),
+///          - number of elements different from ValueType() (SizeFormatter),
+///          - for every such element: distance from previous stored element (IndexFormatter), followed by the element (ValueFormatter).
+///        Distance is the number of default elements skipped, so consecutive stored elements have distance 0.
+///        Distances are small numbers, so varint_formatter is a natural choice for IndexFormatter.
+template<typename SizeFormatter, typename IndexFormatter, typename ValueFormatter>
+class sparse_vector_formatter
+{
+    SizeFormatter size_formatter;
+    IndexFormatter index_formatter;
+    ValueFormatter value_formatter;
+
+public:
+    sparse_vector_formatter(SizeFormatter size_formatter = SizeFormatter(), IndexFormatter index_formatter = IndexFormatter(), ValueFormatter value_formatter = ValueFormatter())
+        : size_formatter(size_formatter)
+        , index_formatter(index_formatter)
+        , value_formatter(value_formatter)
+    {
+    }
+
+    template<typename ValueType, typename TSerializer>
+    void save(TSerializer& serializer, const std::vector<ValueType>& vector) const
+    {
+        const ValueType default_value = ValueType();
+
+        size_t element_count = 0;
+        for (auto& value : vector)
+        {
+            if (!(value == default_value))
+            {
+                ++element_count;
+            }
+        }
+
+        size_formatter.save(serializer, vector.size());
+        size_formatter.save(serializer, element_count);
+
+        size_t next_index = 0;
+        for (size_t i = 0; i < vector.size(); ++i)
+        {
+            if (!(vector[i] == default_value))
+            {
+                index_formatter.save(serializer, i - next_index);
+                value_formatter.save(serializer, vector[i]);
+                next_index = i + 1;
+            }
+        }
+    }
+
+    /// @brief Throws invalid_data if stored elements don't fit in the vector.
+    template<typename ValueType, typename TSerializer>
+    void load(TSerializer& serializer, std::vector<ValueType>& vector) const
+    {
+        size_t vector_size;
+        size_formatter.load(serializer, vector_size);
+
+        size_t element_count;
+        size_formatter.load(serializer, element_count);
+        if (element_count > vector_size)
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("More stored elements than vector size."));
+        }
+
+        vector.assign(vector_size, ValueType());
+
+        size_t next_index = 0;
+        for (size_t i = 0; i < element_count; ++i)
+        {
+            size_t distance;
+            index_formatter.load(serializer, distance);
+            if (distance >= vector_size - next_index)
+            {
+                BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Element index out of range."));
+            }
+
+            next_index += distance;
+            value_formatter.load(serializer, vector[next_index]);
+            ++next_index;
+        }
+    }
+};
+
+template<typename SizeFormatter, typename IndexFormatter, typename ValueFormatter>
+sparse_vector_formatter<SizeFormatter, IndexFormatter, ValueFormatter> create_sparse_vector_formatter(SizeFormatter size_formatter = SizeFormatter(), IndexFormatter index_formatter = IndexFormatter(), ValueFormatter value_formatter = ValueFormatter())
+{
+    return sparse_vector_formatter<SizeFormatter, IndexFormatter, ValueFormatter>(size_formatter, index_formatter, value_formatter);
+}
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_sparse_vector_formatter_H
@@ -14,67 +14,87 @@
 #ifndef ArbitraryFormatSerializer_type_formatter_H
 #define ArbitraryFormatSerializer_type_formatter_H
 
-#include <memory>
+#include <arbitrary_format/implement_save_load_serialize.h>
+#include <arbitrary_format/utility/small_buffer_storage.h>
 
-#include <boost/any.hpp>
+#include <type_traits>
 
 namespace arbitrary_format
 {
 
-/// @todo: Fix this for saving and loading only serializers.
+namespace detail
+{
+
+template<typename TSerializer>
+using can_save_to = std::integral_constant<bool, is_saving_serializer<TSerializer>::value || !is_loading_serializer<TSerializer>::value>;
+
+template<typename TSerializer>
+using can_load_from = std::integral_constant<bool, is_loading_serializer<TSerializer>::value || !is_saving_serializer<TSerializer>::value>;
+
+/// @brief Storage for type erased formatters. Most formatters are small, and are stored without allocation.
+using erased_formatter_storage = small_buffer_storage<>;
+
+} // namespace detail
+
+/// @brief type_formatter stores the formatter in a small buffer, and calls it through a table of function pointers.
+///        Only save() is available for saving serializers, and only load() for loading serializers.
 template<typename TSerializer, typename T>
 class type_formatter
 {
 public:
     template<typename Formatter>
     explicit type_formatter(const Formatter& formatter = Formatter())
-        : typeFormatter(new TypeFormatter<Formatter>(formatter))
+        : formatter(formatter)
+        , functions(formatter_functions<Formatter>::get_table())
     {
     }
 
     void save(TSerializer& serializer, const T& object) const
     {
-        typeFormatter->save(serializer, object);
+        static_assert(detail::can_save_to<TSerializer>::value, "Can't save to a loading serializer.");
+        functions->save(formatter, serializer, object);
     }
 
     void load(TSerializer& serializer, T& object) const
     {
-        typeFormatter->load(serializer, object);
+        static_assert(detail::can_load_from<TSerializer>::value, "Can't load from a saving serializer.");
+        functions->load(formatter, serializer, object);
     }
 
 private:
-    class ITypeFormatter
+    struct function_table
     {
-    public:
-        virtual ~ITypeFormatter() {}
-        virtual void save(TSerializer& serializer, const T& object) const = 0;
-        virtual void load(TSerializer& serializer, T& object) const = 0;
+        void (*save)(const detail::erased_formatter_storage& formatter, TSerializer& serializer, const T& object);
+        void (*load)(const detail::erased_formatter_storage& formatter, TSerializer& serializer, T& object);
     };
 
     template<typename Formatter>
-    class TypeFormatter : public ITypeFormatter
+    struct formatter_functions
     {
-    public:
-        explicit TypeFormatter(const Formatter& formatter = Formatter())
-            : formatter(formatter)
-        {}
-
-    public:
-        virtual void save(TSerializer& serializer, const T& object) const
+        static void save(const detail::erased_formatter_storage& formatter, TSerializer& serializer, const T& object)
         {
-            formatter.save(serializer, object);
+            formatter.template get<Formatter>().save(serializer, object);
         }
 
-        virtual void load(TSerializer& serializer, T& object) const
+        static void load(const detail::erased_formatter_storage& formatter, TSerializer& serializer, T& object)
         {
-            formatter.load(serializer, object);
+            formatter.template get<Formatter>().load(serializer, object);
         }
 
-    private:
-        Formatter formatter;
+        static decltype(&save) save_function(std::true_type)    { return &save; }
+        static decltype(&save) save_function(std::false_type)   { return nullptr; }
+        static decltype(&load) load_function(std::true_type)    { return &load; }
+        static decltype(&load) load_function(std::false_type)   { return nullptr; }
+
+        static const function_table* get_table()
+        {
+            static const function_table table = { save_function(detail::can_save_to<TSerializer>()), load_function(detail::can_load_from<TSerializer>()) };
+            return &table;
+        }
     };
 
-    std::unique_ptr<ITypeFormatter> typeFormatter;
+    detail::erased_formatter_storage formatter;
+    const function_table* functions;
 };
 
 template<typename TSerializer, typename T, typename Formatter>
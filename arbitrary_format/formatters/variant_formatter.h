@@ -0,0 +1,235 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// variant_formatter.h
+///
+/// This file contains variant_formatter that formats boost::variant (and std::variant) as index of the active alternative followed by its value.
+/// Alternatives are saved and loaded through tables of functions, indexed by the alternative index.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_variant_formatter_H
+#define ArbitraryFormatSerializer_variant_formatter_H
+
+#include <arbitrary_format/serialization_exceptions.h>
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+#include <boost/mpl/at.hpp>
+#include <boost/mpl/size.hpp>
+#include <boost/variant.hpp>
+
+#if __cplusplus >= 201703L
+#include <variant>
+#endif
+
+namespace arbitrary_format
+{
+
+/// @brief variant_access is used by variant_formatter to access alternatives of variants.
+///        Specialize it for other variant types.
+/// @note  Last type parameter is to allow for enable_if usage in specializations.
+template<typename Variant, typename Enable = void>
+struct variant_access;
+
+template<BOOST_VARIANT_ENUM_PARAMS(typename T)>
+struct variant_access< boost::variant<BOOST_VARIANT_ENUM_PARAMS(T)> >
+{
+    using variant_type = boost::variant<BOOST_VARIANT_ENUM_PARAMS(T)>;
+
+    static const size_t size = boost::mpl::size<typename variant_type::types>::value;
+
+    template<size_t I>
+    using alternative = typename boost::mpl::at_c<typename variant_type::types, I>::type;
+
+    static size_t index(const variant_type& variant)
+    {
+        return static_cast<size_t>(variant.which());
+    }
+
+    template<size_t I>
+    static const alternative<I>& get(const variant_type& variant)
+    {
+        return boost::get< alternative<I> >(variant);
+    }
+
+    template<size_t I>
+    static alternative<I>& get(variant_type& variant)
+    {
+        return boost::get< alternative<I> >(variant);
+    }
+
+    /// @note boost::variant can't construct alternatives in place. The alternative is value-initialized and moved in.
+    template<size_t I>
+    static alternative<I>& emplace(variant_type& variant)
+    {
+        variant = alternative<I>();
+        return get<I>(variant);
+    }
+};
+
+#if __cplusplus >= 201703L
+
+template<typename... Ts>
+struct variant_access< std::variant<Ts...> >
+{
+    using variant_type = std::variant<Ts...>;
+
+    static const size_t size = sizeof...(Ts);
+
+    template<size_t I>
+    using alternative = std::variant_alternative_t<I, variant_type>;
+
+    /// @note Returns std::variant_npos for variants that are valueless by exception.
+    static size_t index(const variant_type& variant)
+    {
+        return variant.index();
+    }
+
+    template<size_t I>
+    static const alternative<I>& get(const variant_type& variant)
+    {
+        return std::get<I>(variant);
+    }
+
+    template<size_t I>
+    static alternative<I>& get(variant_type& variant)
+    {
+        return std::get<I>(variant);
+    }
+
+    template<size_t I>
+    static alternative<I>& emplace(variant_type& variant)
+    {
+        return variant.template emplace<I>();
+    }
+};
+
+#endif
+
+namespace detail
+{
+
+template<size_t... Is>
+struct variant_indices
+{};
+
+template<size_t N, size_t... Is>
+struct make_variant_indices : public make_variant_indices<N - 1, N - 1, Is...>
+{};
+
+template<size_t... Is>
+struct make_variant_indices<0, Is...>
+{
+    using type = variant_indices<Is...>;
+};
+
+} // namespace detail
+
+/// @brief variant_formatter stores a variant as index of the active alternative, formatted with TagFormatter,
+///        followed by value of the alternative, formatted with corresponding AlternativeFormatter.
+///        On load, if the loaded alternative is already active it's loaded in place. Otherwise it's value-initialized first.
+///        Throws invalid_data if loaded index is out of range.
+template<typename TagFormatter, typename... AlternativeFormatters>
+class variant_formatter
+{
+    using indices = typename detail::make_variant_indices<sizeof...(AlternativeFormatters)>::type;
+
+    TagFormatter tag_formatter;
+    std::tuple<AlternativeFormatters...> alternative_formatters;
+
+public:
+    variant_formatter() = default;
+
+    explicit variant_formatter(TagFormatter tag_formatter, AlternativeFormatters... alternative_formatters)
+        : tag_formatter(tag_formatter)
+        , alternative_formatters(alternative_formatters...)
+    {
+    }
+
+    template<typename Variant, typename TSerializer>
+    void save(TSerializer& serializer, const Variant& variant) const
+    {
+        static_assert(variant_access<Variant>::size == sizeof...(AlternativeFormatters), "variant_formatter must have a formatter for every alternative.");
+
+        size_t index = variant_access<Variant>::index(variant);
+        if (index >= sizeof...(AlternativeFormatters))
+        {
+            BOOST_THROW_EXCEPTION(serialization_exception() << errinfo_description("Can't save a variant without value."));
+        }
+
+        tag_formatter.save(serializer, index);
+        save_functions<Variant, TSerializer>(indices())[index](*this, serializer, variant);
+    }
+
+    template<typename Variant, typename TSerializer>
+    void load(TSerializer& serializer, Variant& variant) const
+    {
+        static_assert(variant_access<Variant>::size == sizeof...(AlternativeFormatters), "variant_formatter must have a formatter for every alternative.");
+
+        size_t index;
+        tag_formatter.load(serializer, index);
+        if (index >= sizeof...(AlternativeFormatters))
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Variant alternative index out of range."));
+        }
+
+        load_functions<Variant, TSerializer>(indices())[index](*this, serializer, variant);
+    }
+
+private:
+    template<typename Variant, typename TSerializer>
+    using save_function = void (*)(const variant_formatter& formatter, TSerializer& serializer, const Variant& variant);
+
+    template<typename Variant, typename TSerializer>
+    using load_function = void (*)(const variant_formatter& formatter, TSerializer& serializer, Variant& variant);
+
+    template<size_t I, typename Variant, typename TSerializer>
+    static void save_alternative(const variant_formatter& formatter, TSerializer& serializer, const Variant& variant)
+    {
+        std::get<I>(formatter.alternative_formatters).save(serializer, variant_access<Variant>::template get<I>(variant));
+    }
+
+    template<size_t I, typename Variant, typename TSerializer>
+    static void load_alternative(const variant_formatter& formatter, TSerializer& serializer, Variant& variant)
+    {
+        if (variant_access<Variant>::index(variant) == I)
+        {
+            std::get<I>(formatter.alternative_formatters).load(serializer, variant_access<Variant>::template get<I>(variant));
+        }
+        else
+        {
+            std::get<I>(formatter.alternative_formatters).load(serializer, variant_access<Variant>::template emplace<I>(variant));
+        }
+    }
+
+    template<typename Variant, typename TSerializer, size_t... Is>
+    static const save_function<Variant, TSerializer>* save_functions(detail::variant_indices<Is...>)
+    {
+        static const save_function<Variant, TSerializer> functions[] = { &save_alternative<Is, Variant, TSerializer>... };
+        return functions;
+    }
+
+    template<typename Variant, typename TSerializer, size_t... Is>
+    static const load_function<Variant, TSerializer>* load_functions(detail::variant_indices<Is...>)
+    {
+        static const load_function<Variant, TSerializer> functions[] = { &load_alternative<Is, Variant, TSerializer>... };
+        return functions;
+    }
+};
+
+template<typename TagFormatter, typename... AlternativeFormatters>
+variant_formatter<TagFormatter, AlternativeFormatters...> create_variant_formatter(TagFormatter tag_formatter = TagFormatter(), AlternativeFormatters... alternative_formatters)
+{
+    return variant_formatter<TagFormatter, AlternativeFormatters...>(tag_formatter, alternative_formatters...);
+}
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_variant_formatter_H
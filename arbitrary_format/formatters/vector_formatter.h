@@ -5,6 +5,7 @@
 /// vector_formatter.h
 ///
 /// This file contains vector_formatter that formats std::vector as length field followed by individual values.
+/// Vectors of verbatim values can also be loaded as boost::iterator_range pointing directly into the serializer's buffer.
 ///
 /// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
 /// (c) 2014 Zbigniew Skowron, zbychs@gmail.com
@@ -16,10 +17,14 @@
 
 #include <arbitrary_format/formatters/serialize_buffer.h>
 #include <arbitrary_format/binary_formatters/verbatim_formatter.h>
+#include <arbitrary_format/serialization_exceptions.h>
 
+#include <cstdint>
 #include <vector>
 #include <type_traits>
 
+#include <boost/range/iterator_range.hpp>
+
 namespace arbitrary_format
 {
 
@@ -36,21 +41,53 @@ public:
     {
     }
 
-    template<typename ValueType, typename TSerializer>
-    void save(TSerializer& serializer, const std::vector<ValueType>& vector) const
+    template<typename ValueType, typename Allocator, typename TSerializer>
+    void save(TSerializer& serializer, const std::vector<ValueType, Allocator>& vector) const
     {
         size_formatter.save(serializer, vector.size());
         save_buffer(serializer, vector.size(), vector.data(), value_formatter);
     }
 
+    /// @note Vectors of values loaded verbatim are not zero-filled before loading. See load_sequence().
+    template<typename ValueType, typename Allocator, typename TSerializer>
+    void load(TSerializer& serializer, std::vector<ValueType, Allocator>& vector) const
+    {
+        size_t vector_size;
+        size_formatter.load(serializer, vector_size);
+
+        load_sequence(serializer, vector_size, vector, value_formatter);
+    }
+
     template<typename ValueType, typename TSerializer>
-    void load(TSerializer& serializer, std::vector<ValueType>& vector) const
+    void save(TSerializer& serializer, const boost::iterator_range<const ValueType*>& range) const
     {
+        size_formatter.save(serializer, range.size());
+        save_buffer(serializer, range.size(), range.begin(), value_formatter);
+    }
+
+    /// @brief Loads a range pointing directly to elements in the serializer's buffer. Elements are not copied.
+    ///        Requires a serializer with viewData() method (like MemoryLoadSerializer), and elements loaded verbatim.
+    ///        Throws invalid_data if the elements are not aligned in memory. See aligned_formatter.
+    template<typename ValueType, typename TSerializer>
+    void load(TSerializer& serializer, boost::iterator_range<const ValueType*>& range) const
+    {
+        static_assert(binary::is_verbatim_formatter<ValueFormatter, ValueType>::value, "Only elements loaded verbatim can be viewed in place.");
+
         size_t vector_size;
         size_formatter.load(serializer, vector_size);
+        if (vector_size > SIZE_MAX / sizeof(ValueType))
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Vector size too big."));
+        }
+
+        const uint8_t* data = serializer.viewData(vector_size * sizeof(ValueType));
+        if (reinterpret_cast<uintptr_t>(data) % alignof(ValueType) != 0)
+        {
+            BOOST_THROW_EXCEPTION(invalid_data() << errinfo_description("Vector elements are not aligned in memory."));
+        }
 
-        vector.resize(vector_size);
-        load_buffer(serializer, vector_size, vector.data(), value_formatter);
+        const ValueType* begin = reinterpret_cast<const ValueType*>(data);
+        range = boost::make_iterator_range(begin, begin + vector_size);
     }
 };
 
@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// default_init_allocator.h
+///
+/// This file contains default_init_allocator - an allocator adaptor that default-initializes elements instead of value-initializing them.
+/// For std::vector<uint8_t, default_init_allocator<uint8_t>> resize() doesn't zero-fill new elements,
+/// which is useful when they are about to be overwritten anyway, for example by load_buffer().
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_default_init_allocator_H
+#define ArbitraryFormatSerializer_default_init_allocator_H
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace arbitrary_format
+{
+
+template<typename T, typename Allocator = std::allocator<T>>
+class default_init_allocator : public Allocator
+{
+    using traits = std::allocator_traits<Allocator>;
+
+public:
+    template<typename U>
+    struct rebind
+    {
+        using other = default_init_allocator<U, typename traits::template rebind_alloc<U>>;
+    };
+
+    using Allocator::Allocator;
+
+    default_init_allocator() = default;
+
+    template<typename U, typename OtherAllocator>
+    default_init_allocator(const default_init_allocator<U, OtherAllocator>& other) noexcept
+        : Allocator(other)
+    {
+    }
+
+    /// @brief Default-initializes the element: PODs are left uninitialized.
+    template<typename U>
+    void construct(U* ptr) noexcept(std::is_nothrow_default_constructible<U>::value)
+    {
+        ::new (static_cast<void*>(ptr)) U;
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* ptr, Args&&... args)
+    {
+        traits::construct(static_cast<Allocator&>(*this), ptr, std::forward<Args>(args)...);
+    }
+};
+
+/// @brief is_default_init_allocator is a true_type if containers using given allocator don't value-initialize elements on resize().
+template<typename Allocator>
+struct is_default_init_allocator : public std::false_type
+{};
+
+template<typename T, typename Allocator>
+struct is_default_init_allocator< default_init_allocator<T, Allocator> > : public std::true_type
+{};
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_default_init_allocator_H
@@ -0,0 +1,169 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// pool_allocator.h
+///
+/// This file contains node_pool - a pool of small memory blocks, and pool_allocator - an allocator that allocates from a node_pool.
+/// Blocks are carved from big chunks and kept on per-size free lists when freed, so allocating many small objects
+/// (like nodes created by std::allocate_shared) costs just a few instructions.
+/// NOTE: node_pool is not thread safe, and must outlive all objects allocated from it.
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_pool_allocator_H
+#define ArbitraryFormatSerializer_pool_allocator_H
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace arbitrary_format
+{
+
+/// @brief Pool of memory blocks of up to max_block_size bytes. Bigger blocks are allocated with operator new.
+///        Memory of freed blocks is reused, but returned to the system only when the pool is destroyed.
+class node_pool
+{
+public:
+    static const size_t granularity = alignof(std::max_align_t);
+    static const size_t max_block_size = 256;
+
+    explicit node_pool(size_t chunk_size = 64 * 1024)
+        : chunk_size(std::max(chunk_size, static_cast<size_t>(max_block_size)))
+        , chunk_position(nullptr)
+        , chunk_remaining(0)
+    {
+        std::fill(std::begin(free_lists), std::end(free_lists), nullptr);
+    }
+
+    node_pool(const node_pool&) = delete;
+    node_pool& operator=(const node_pool&) = delete;
+
+    void* allocate(size_t size)
+    {
+        if (size > max_block_size)
+        {
+            return ::operator new(size);
+        }
+
+        size_t size_class = get_size_class(size);
+        if (free_node* node = free_lists[size_class])
+        {
+            free_lists[size_class] = node->next;
+            return node;
+        }
+
+        size_t block_size = size_class * granularity;
+        if (chunk_remaining < block_size)
+        {
+            new_chunk();
+        }
+        void* block = chunk_position;
+        chunk_position += block_size;
+        chunk_remaining -= block_size;
+        return block;
+    }
+
+    void deallocate(void* block, size_t size)
+    {
+        if (size > max_block_size)
+        {
+            ::operator delete(block);
+            return;
+        }
+
+        size_t size_class = get_size_class(size);
+        free_node* node = static_cast<free_node*>(block);
+        node->next = free_lists[size_class];
+        free_lists[size_class] = node;
+    }
+
+private:
+    struct free_node
+    {
+        free_node* next;
+    };
+
+    using chunk = std::unique_ptr<std::max_align_t[]>;
+
+    static size_t get_size_class(size_t size)
+    {
+        return std::max<size_t>(1, (size + granularity - 1) / granularity);
+    }
+
+    void new_chunk()
+    {
+        chunks.emplace_back(new std::max_align_t[(chunk_size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)]);
+        chunk_position = reinterpret_cast<char*>(chunks.back().get());
+        chunk_remaining = chunk_size;
+    }
+
+    size_t chunk_size;
+    char* chunk_position;
+    size_t chunk_remaining;
+    free_node* free_lists[max_block_size / granularity + 1];
+    std::vector<chunk> chunks;
+};
+
+/// @brief Allocator that allocates from a node_pool. Copies (and rebound copies) share the pool.
+template<typename T>
+class pool_allocator
+{
+    static_assert(alignof(T) <= node_pool::granularity, "Over-aligned types can't be allocated from a node_pool.");
+
+    template<typename U>
+    friend class pool_allocator;
+
+    node_pool* pool;
+
+public:
+    using value_type = T;
+
+    explicit pool_allocator(node_pool& pool) noexcept
+        : pool(&pool)
+    {
+    }
+
+    template<typename U>
+    pool_allocator(const pool_allocator<U>& other) noexcept
+        : pool(other.pool)
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        if (count > std::numeric_limits<size_t>::max() / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(pool->allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t count) noexcept
+    {
+        pool->deallocate(ptr, count * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const pool_allocator<U>& other) const noexcept
+    {
+        return pool == other.pool;
+    }
+
+    template<typename U>
+    bool operator!=(const pool_allocator<U>& other) const noexcept
+    {
+        return pool != other.pool;
+    }
+};
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_pool_allocator_H
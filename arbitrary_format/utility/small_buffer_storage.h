@@ -0,0 +1,228 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// small_buffer_storage.h
+///
+/// This file contains small_buffer_storage - a copyable storage for an object of any type, that doesn't allocate for small objects.
+/// It's meant for type erasure: type of the stored object is not remembered, and must be known by the user
+/// (usually because the user keeps function pointers instantiated for this type).
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_small_buffer_storage_H
+#define ArbitraryFormatSerializer_small_buffer_storage_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace arbitrary_format
+{
+
+/// @brief Unique tag of a type, that can be compared without RTTI.
+/// @note  id is not const, so that the linker can't merge tags of different types.
+template<typename T>
+struct type_tag
+{
+    static char id;
+};
+
+template<typename T>
+char type_tag<T>::id = 0;
+
+/// @brief Storage for one object, that is kept in place if it's no bigger than BufferSize and can be moved without throwing,
+///        and on the heap otherwise.
+template<size_t BufferSize = 4 * sizeof(void*)>
+class small_buffer_storage
+{
+    static_assert(BufferSize >= sizeof(void*), "Buffer must be big enough to hold a pointer to objects stored on the heap.");
+
+public:
+    template<typename T>
+    using fits_in_buffer = std::integral_constant<bool, (sizeof(T) <= BufferSize) && (alignof(T) <= alignof(std::max_align_t)) && std::is_nothrow_move_constructible<T>::value>;
+
+    small_buffer_storage() noexcept
+        : manager(nullptr)
+    {
+    }
+
+    template<typename T, typename = typename std::enable_if< !std::is_same<typename std::decay<T>::type, small_buffer_storage>::value >::type>
+    explicit small_buffer_storage(T&& object)
+        : manager(nullptr)
+    {
+        emplace<typename std::decay<T>::type>(std::forward<T>(object));
+    }
+
+    small_buffer_storage(const small_buffer_storage& other)
+        : manager(nullptr)
+    {
+        if (other.manager)
+        {
+            other.manager(operation::copy, this, const_cast<small_buffer_storage*>(&other));
+        }
+    }
+
+    small_buffer_storage(small_buffer_storage&& other) noexcept
+        : manager(nullptr)
+    {
+        if (other.manager)
+        {
+            other.manager(operation::move, this, &other);
+        }
+    }
+
+    small_buffer_storage& operator=(const small_buffer_storage& other)
+    {
+        if (this != &other)
+        {
+            small_buffer_storage copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    small_buffer_storage& operator=(small_buffer_storage&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            if (other.manager)
+            {
+                other.manager(operation::move, this, &other);
+            }
+        }
+        return *this;
+    }
+
+    ~small_buffer_storage()
+    {
+        reset();
+    }
+
+    template<typename T, typename... Args>
+    void emplace(Args&&... args)
+    {
+        reset();
+        construct<T>(fits_in_buffer<T>(), std::forward<Args>(args)...);
+        manager = &manage<T>;
+    }
+
+    void reset() noexcept
+    {
+        if (manager)
+        {
+            manager(operation::destroy, this, this);
+            manager = nullptr;
+        }
+    }
+
+    bool empty() const noexcept
+    {
+        return manager == nullptr;
+    }
+
+    /// @note T must be the type of the stored object. It is not checked.
+    template<typename T>
+    T& get() noexcept
+    {
+        return *pointer<T>(fits_in_buffer<T>());
+    }
+
+    /// @note T must be the type of the stored object. It is not checked.
+    template<typename T>
+    const T& get() const noexcept
+    {
+        return *const_cast<small_buffer_storage*>(this)->pointer<T>(fits_in_buffer<T>());
+    }
+
+private:
+    enum class operation
+    {
+        copy,
+        move,
+        destroy,
+    };
+
+    using manager_function = void (*)(operation, small_buffer_storage* target, small_buffer_storage* source);
+
+    template<typename T, typename... Args>
+    void construct(std::true_type, Args&&... args)
+    {
+        ::new (static_cast<void*>(&buffer)) T(std::forward<Args>(args)...);
+    }
+
+    template<typename T, typename... Args>
+    void construct(std::false_type, Args&&... args)
+    {
+        ::new (static_cast<void*>(&buffer)) T*(new T(std::forward<Args>(args)...));
+    }
+
+    template<typename T>
+    T* pointer(std::true_type) noexcept
+    {
+        return reinterpret_cast<T*>(&buffer);
+    }
+
+    template<typename T>
+    T* pointer(std::false_type) noexcept
+    {
+        return *reinterpret_cast<T**>(&buffer);
+    }
+
+    template<typename T>
+    static void manage(operation op, small_buffer_storage* target, small_buffer_storage* source)
+    {
+        switch (op)
+        {
+        case operation::copy:
+            target->construct<T>(fits_in_buffer<T>(), source->get<T>());
+            target->manager = source->manager;
+            break;
+        case operation::move:
+            relocate<T>(fits_in_buffer<T>(), target, source);
+            target->manager = source->manager;
+            source->manager = nullptr;
+            break;
+        case operation::destroy:
+            destroy<T>(fits_in_buffer<T>(), source);
+            break;
+        }
+    }
+
+    template<typename T>
+    static void relocate(std::true_type, small_buffer_storage* target, small_buffer_storage* source) noexcept
+    {
+        target->construct<T>(std::true_type(), std::move(source->get<T>()));
+        source->get<T>().~T();
+    }
+
+    template<typename T>
+    static void relocate(std::false_type, small_buffer_storage* target, small_buffer_storage* source) noexcept
+    {
+        ::new (static_cast<void*>(&target->buffer)) T*(source->pointer<T>(std::false_type()));
+    }
+
+    template<typename T>
+    static void destroy(std::true_type, small_buffer_storage* storage) noexcept
+    {
+        storage->get<T>().~T();
+    }
+
+    template<typename T>
+    static void destroy(std::false_type, small_buffer_storage* storage) noexcept
+    {
+        delete storage->pointer<T>(std::false_type());
+    }
+
+    typename std::aligned_storage<BufferSize, alignof(std::max_align_t)>::type buffer;
+    manager_function manager;
+};
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_small_buffer_storage_H
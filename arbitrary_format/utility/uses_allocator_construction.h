@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////////////////////
+/// ArbitraryFormatSerializer
+///    Library for serializing data in arbitrary formats.
+///
+/// uses_allocator_construction.h
+///
+/// This file contains make_using_allocator() function, that default-constructs a value using given allocator, if the value is allocator-aware.
+/// Values loaded this way into a temporary can then be moved into a container without reallocation,
+/// as they already use the container's allocator (for example a std::pmr arena).
+///
+/// Distributed under Apache License, Version 2.0 (http://www.apache.org/licenses/LICENSE-2.0)
+/// (c) 2016 Zbigniew Skowron, zbychs@gmail.com
+///
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ArbitraryFormatSerializer_uses_allocator_construction_H
+#define ArbitraryFormatSerializer_uses_allocator_construction_H
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace arbitrary_format
+{
+
+/// @brief uses_allocator_construction<T, Allocator>::make(allocator) default-constructs T, passing it the allocator if T uses it,
+///        either as leading std::allocator_arg, allocator arguments, or as a trailing allocator argument.
+///        Both elements of std::pair are constructed this way.
+/// @note  Last type parameter is to allow for enable_if usage in specializations.
+template<typename T, typename Allocator, typename Enable = void>
+struct uses_allocator_construction
+{
+    static T make(const Allocator&)
+    {
+        return T();
+    }
+};
+
+template<typename T, typename Allocator>
+struct uses_allocator_construction< T, Allocator, typename std::enable_if< std::uses_allocator<T, Allocator>::value && std::is_constructible<T, std::allocator_arg_t, const Allocator&>::value >::type >
+{
+    static T make(const Allocator& allocator)
+    {
+        return T(std::allocator_arg, allocator);
+    }
+};
+
+template<typename T, typename Allocator>
+struct uses_allocator_construction< T, Allocator, typename std::enable_if< std::uses_allocator<T, Allocator>::value && !std::is_constructible<T, std::allocator_arg_t, const Allocator&>::value >::type >
+{
+    static T make(const Allocator& allocator)
+    {
+        return T(allocator);
+    }
+};
+
+template<typename T1, typename T2, typename Allocator>
+struct uses_allocator_construction< std::pair<T1, T2>, Allocator >
+{
+    static std::pair<T1, T2> make(const Allocator& allocator)
+    {
+        return std::pair<T1, T2>(uses_allocator_construction<T1, Allocator>::make(allocator), uses_allocator_construction<T2, Allocator>::make(allocator));
+    }
+};
+
+template<typename T, typename Allocator>
+T make_using_allocator(const Allocator& allocator)
+{
+    return uses_allocator_construction<T, Allocator>::make(allocator);
+}
+
+} // namespace arbitrary_format
+
+#endif // ArbitraryFormatSerializer_uses_allocator_construction_H
@@ -0,0 +1,573 @@
+// CompactFormattersTests.cpp - tests for BinaryFormatSerializer
+//
+
+#include <arbitrary_format/serialize.h>
+#include <arbitrary_format/binary_serializers/VectorSaveSerializer.h>
+#include <arbitrary_format/binary_serializers/MemorySerializer.h>
+
+#include <arbitrary_format/binary_formatters/endian_formatter.h>
+#include <arbitrary_format/binary_formatters/half_float_formatter.h>
+#include <arbitrary_format/binary_formatters/interned_string_formatter.h>
+#include <arbitrary_format/binary_formatters/string_formatter.h>
+#include <arbitrary_format/binary_formatters/packed_bits_formatter.h>
+#include <arbitrary_format/binary_formatters/presence_bitmap_formatter.h>
+#include <arbitrary_format/binary_formatters/quantized_formatter.h>
+#include <arbitrary_format/binary_formatters/varint_formatter.h>
+#include <arbitrary_format/formatters/array_formatter.h>
+#include <arbitrary_format/formatters/const_formatter.h>
+#include <arbitrary_format/formatters/dictionary_vector_formatter.h>
+#include <arbitrary_format/formatters/rle_vector_formatter.h>
+#include <arbitrary_format/formatters/sparse_vector_formatter.h>
+#include <arbitrary_format/formatters/vector_formatter.h>
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <cstdint>
+#include <limits>
+
+#include <boost/optional/optional_io.hpp>
+
+namespace {
+
+using namespace arbitrary_format;
+using namespace binary;
+
+TEST(DictionaryVectorFormatterWorks, SavingAndLoading)
+{
+    using dictionary_format = dictionary_vector_formatter< little_endian<1>, string_formatter< little_endian<1> >, little_endian<1> >;
+    const auto value = std::vector<std::string> { "ok", "error", "ok", "ok", "error" };
+    const auto data = std::vector<uint8_t> { 0x02, 0x02, 'o', 'k', 0x05, 'e', 'r', 'r', 'o', 'r', 0x05, 0x00, 0x01, 0x00, 0x00, 0x01 };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save<dictionary_format>(vectorWriter, value);
+        EXPECT_EQ(vectorWriter.getData(), data);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        load< const_formatter<dictionary_format> >(vectorReader, value);
+    }
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save<dictionary_format>(vectorWriter, std::vector<std::string>());
+        const auto checkValue = std::vector<uint8_t> { 0x00, 0x00 };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+    }
+
+    {
+        std::vector<uint8_t> badData { 0x01, 0x02, 'o', 'k', 0x02, 0x00, 0x01 };
+        MemoryLoadSerializer vectorReader(badData);
+        std::vector<std::string> loadedValue;
+        ASSERT_THROW(load<dictionary_format>(vectorReader, loadedValue), invalid_data);
+    }
+}
+
+TEST(RleVectorFormatterWorks, SavingAndLoading)
+{
+    using rle_format = rle_vector_formatter< little_endian<2>, little_endian<1>, little_endian<1> >;
+    const auto value = std::vector<int> { 7, 7, 7, 7, 1, 2, 2 };
+    const auto data = std::vector<uint8_t> { 0x07, 0x00, 7, 4, 1, 1, 2, 2 };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save<rle_format>(vectorWriter, value);
+        EXPECT_EQ(vectorWriter.getData(), data);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        load< const_formatter<rle_format> >(vectorReader, value);
+    }
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save<rle_format>(vectorWriter, std::vector<int>());
+        const auto checkValue = std::vector<uint8_t> { 0x00, 0x00 };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+    }
+
+    {
+        std::vector<uint8_t> badData { 0x03, 0x00, 7, 4 };
+        MemoryLoadSerializer vectorReader(badData);
+        std::vector<int> loadedValue;
+        ASSERT_THROW(load<rle_format>(vectorReader, loadedValue), invalid_data);
+    }
+
+    {
+        std::vector<uint8_t> badData { 0x03, 0x00, 7, 0 };
+        MemoryLoadSerializer vectorReader(badData);
+        std::vector<int> loadedValue;
+        ASSERT_THROW(load<rle_format>(vectorReader, loadedValue), invalid_data);
+    }
+}
+
+TEST(VarintFormatterWorks, SavingAndLoading)
+{
+    {
+        VectorSaveSerializer vectorWriter;
+        save<varint_formatter>(vectorWriter, 1);
+        save<varint_formatter>(vectorWriter, 300u);
+        save<varint_formatter>(vectorWriter, -1);
+        save<varint_formatter>(vectorWriter, -64);
+        save<varint_formatter>(vectorWriter, 64);
+        const auto checkValue = std::vector<uint8_t> { 0x02, 0xAC, 0x02, 0x01, 0x7F, 0x80, 0x01 };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+    }
+
+    {
+        std::vector<uint8_t> data { 0x02, 0xAC, 0x02, 0x01, 0x7F, 0x80, 0x01 };
+        MemoryLoadSerializer vectorReader(data);
+        load< const_formatter<varint_formatter> >(vectorReader, 1);
+        load< const_formatter<varint_formatter> >(vectorReader, 300u);
+        load< const_formatter<varint_formatter> >(vectorReader, -1);
+        load< const_formatter<varint_formatter> >(vectorReader, -64);
+        load< const_formatter<varint_formatter> >(vectorReader, 64);
+    }
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save<varint_formatter>(vectorWriter, std::numeric_limits<uint64_t>::max());
+        save<varint_formatter>(vectorWriter, std::numeric_limits<int64_t>::min());
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        load< const_formatter<varint_formatter> >(vectorReader, std::numeric_limits<uint64_t>::max());
+        load< const_formatter<varint_formatter> >(vectorReader, std::numeric_limits<int64_t>::min());
+    }
+
+    {
+        std::vector<uint8_t> data { 0xAC, 0x02 };
+        MemoryLoadSerializer vectorReader(data);
+        uint8_t value;
+        ASSERT_THROW(load<varint_formatter>(vectorReader, value), invalid_data);
+    }
+
+    {
+        std::vector<uint8_t> data { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02 };
+        MemoryLoadSerializer vectorReader(data);
+        uint64_t value;
+        ASSERT_THROW(load<varint_formatter>(vectorReader, value), invalid_data);
+    }
+}
+
+TEST(InternedStringFormatterWorks, SavingAndLoading)
+{
+    const auto value = std::vector<std::string> { "host", "tag", "host", "host", "tag" };
+    const auto data = std::vector<uint8_t> { 0x05, 0x00, 0x04, 'h', 'o', 's', 't', 0x00, 0x03, 't', 'a', 'g', 0x01, 0x01, 0x02 };
+
+    {
+        string_interning_context context;
+        VectorSaveSerializer vectorWriter;
+        save(vectorWriter, value, create_vector_formatter(little_endian<1>(), create_interned_string_formatter(context)));
+        EXPECT_EQ(vectorWriter.getData(), data);
+
+        /// @brief dictionary spans whole stream
+        save(vectorWriter, "tag", create_interned_string_formatter(context));
+        save(vectorWriter, boost::string_ref("new"), create_interned_string_formatter(context));
+        const auto moreData = std::vector<uint8_t> { 0x02, 0x00, 0x03, 'n', 'e', 'w' };
+        EXPECT_TRUE(std::equal(moreData.begin(), moreData.end(), vectorWriter.getData().begin() + data.size()));
+    }
+
+    /// @brief strings are looked up by view, but the dictionary keeps its own copies
+    {
+        string_interning_context context;
+        VectorSaveSerializer vectorWriter;
+        auto string_format = create_interned_string_formatter(context);
+        char buffer[] = "ab";
+        save(vectorWriter, boost::string_ref(buffer), string_format);
+        buffer[0] = 'x';
+        save(vectorWriter, boost::string_ref(buffer), string_format);
+        save(vectorWriter, std::string("ab"), string_format);
+        save(vectorWriter, "xb", string_format);
+        const auto checkData = std::vector<uint8_t> { 0x00, 0x02, 'a', 'b', 0x00, 0x02, 'x', 'b', 0x01, 0x02 };
+        EXPECT_EQ(vectorWriter.getData(), checkData);
+    }
+
+    {
+        string_interning_context context;
+        MemoryLoadSerializer vectorReader(data);
+        std::vector<std::string> loadedValue;
+        load(vectorReader, loadedValue, create_vector_formatter(little_endian<1>(), create_interned_string_formatter(context)));
+        EXPECT_EQ(loadedValue, value);
+    }
+
+    /// @brief loading views of interned strings
+    {
+        string_interning_context context;
+        MemoryLoadSerializer vectorReader(data);
+        std::vector<boost::string_ref> loadedValue;
+        load(vectorReader, loadedValue, create_vector_formatter(little_endian<1>(), create_interned_string_formatter(context)));
+        ASSERT_EQ(loadedValue.size(), value.size());
+        for (size_t i = 0; i < value.size(); ++i)
+        {
+            EXPECT_EQ(loadedValue[i].to_string(), value[i]);
+        }
+        EXPECT_EQ(loadedValue[0].data(), loadedValue[2].data());
+        EXPECT_EQ(loadedValue[1].data(), loadedValue[4].data());
+    }
+
+    {
+        const auto badData = std::vector<uint8_t> { 0x02, 0x00, 0x01, 'a', 0x02 };
+        string_interning_context context;
+        MemoryLoadSerializer vectorReader(badData);
+        std::vector<std::string> loadedValue;
+        ASSERT_THROW(load(vectorReader, loadedValue, create_vector_formatter(little_endian<1>(), create_interned_string_formatter(context))), invalid_data);
+    }
+}
+
+TEST(SparseVectorFormatterWorks, SavingAndLoading)
+{
+    using sparse_format = sparse_vector_formatter< little_endian<2>, varint_formatter, little_endian<4> >;
+    const auto value = std::vector<float> { 0.0f, 0.0f, 1.5f, 2.5f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save<sparse_format>(vectorWriter, value);
+        EXPECT_EQ(vectorWriter.getData().size(), 4u + 3u * 5u);
+
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        auto loadedValue = std::vector<float>(20, 3.0f);
+        load<sparse_format>(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, value);
+    }
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save< sparse_vector_formatter< little_endian<1>, varint_formatter, little_endian<1> > >(vectorWriter, std::vector<int> { 0, 5, 6, 0, 0, 7 });
+        const auto checkValue = std::vector<uint8_t> { 0x06, 0x03, 0x01, 0x05, 0x00, 0x06, 0x02, 0x07 };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+    }
+
+    {
+        std::vector<uint8_t> data { 0x03, 0x02, 0x01, 0x05, 0x01, 0x06 };
+        MemoryLoadSerializer vectorReader(data);
+        std::vector<int> loadedValue;
+        ASSERT_THROW((load< sparse_vector_formatter< little_endian<1>, varint_formatter, little_endian<1> > >(vectorReader, loadedValue)), invalid_data);
+    }
+}
+
+TEST(PackedBitsFormatterWorks, SavingAndLoading)
+{
+    using bits_format = packed_bits_formatter< little_endian<2> >;
+
+    {
+        const auto value = std::vector<bool> { true, false, false, true, true, false, true, false, true, true };
+        VectorSaveSerializer vectorWriter;
+        save<bits_format>(vectorWriter, value);
+        const auto checkValue = std::vector<uint8_t> { 0x0A, 0x00, 0x59, 0x03 };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        std::vector<bool> loadedValue(3, true);
+        load<bits_format>(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, value);
+    }
+
+    {
+        std::vector<bool> value(1000);
+        for (size_t i = 0; i < value.size(); i += 3)
+        {
+            value[i] = true;
+        }
+
+        VectorSaveSerializer vectorWriter;
+        save<bits_format>(vectorWriter, value);
+        EXPECT_EQ(vectorWriter.getData().size(), 2u + 125u);
+
+        boost::dynamic_bitset<uint32_t> dynamicBits;
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        load<bits_format>(vectorReader, dynamicBits);
+        ASSERT_EQ(dynamicBits.size(), value.size());
+        for (size_t i = 0; i < value.size(); ++i)
+        {
+            EXPECT_EQ(dynamicBits[i], value[i]);
+        }
+
+        VectorSaveSerializer dynamicWriter;
+        save<bits_format>(dynamicWriter, dynamicBits);
+        EXPECT_EQ(dynamicWriter.getData(), vectorWriter.getData());
+    }
+
+    {
+        std::bitset<12> value(0x0A53);
+        VectorSaveSerializer vectorWriter;
+        save<bits_format>(vectorWriter, value);
+        const auto checkValue = std::vector<uint8_t> { 0x53, 0x0A };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        std::bitset<12> loadedValue;
+        load<bits_format>(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, value);
+    }
+
+    /// @brief bitsets longer than one word
+    {
+        std::bitset<130> value;
+        value.set(0).set(63).set(64).set(100).set(129);
+        VectorSaveSerializer vectorWriter;
+        save<bits_format>(vectorWriter, value);
+        auto checkValue = std::vector<uint8_t>(17, 0);
+        checkValue[0] = 0x01;
+        checkValue[7] = 0x80;
+        checkValue[8] = 0x01;
+        checkValue[12] = 0x10;
+        checkValue[16] = 0x02;
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        std::bitset<130> loadedValue;
+        load<bits_format>(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, value);
+    }
+
+    {
+        std::vector<uint8_t> data { 0x0A, 0x00, 0x59, 0x07 };
+        MemoryLoadSerializer vectorReader(data);
+        std::vector<bool> loadedValue;
+        ASSERT_THROW(load<bits_format>(vectorReader, loadedValue), invalid_data);
+    }
+}
+
+TEST(PresenceBitmapFormatterWorks, SavingAndLoading)
+{
+    using presence_format = presence_bitmap_formatter< little_endian<1>, little_endian<2>, string_formatter< little_endian<1> >, little_endian<1>,
+                                                       little_endian<1>, little_endian<1>, little_endian<1>, little_endian<1>, little_endian<4> >;
+    using record_type = std::tuple< boost::optional<int>, boost::optional<int>, boost::optional<std::string>, boost::optional<int>,
+                                    boost::optional<int>, boost::optional<int>, boost::optional<int>, boost::optional<int>, boost::optional<int> >;
+
+    const record_type value { 5, boost::none, std::string("ab"), boost::none, boost::none, boost::none, boost::none, boost::none, 0x01020304 };
+    const auto data = std::vector<uint8_t> { 0x05, 0x01, 0x05, 0x02, 'a', 'b', 0x04, 0x03, 0x02, 0x01 };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save<presence_format>(vectorWriter, value);
+        EXPECT_EQ(vectorWriter.getData(), data);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        record_type loadedValue { boost::none, 7, std::string("xyz"), 1, 1, 1, 1, 1, boost::none };
+        load<presence_format>(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, value);
+    }
+
+    {
+        boost::optional<int> a;
+        boost::optional<std::string> b;
+        VectorSaveSerializer vectorWriter;
+        save< presence_bitmap_formatter< little_endian<1>, string_formatter< little_endian<1> > > >(vectorWriter, std::tie(a, b));
+        const auto checkValue = std::vector<uint8_t> { 0x00 };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+
+        a = 3;
+        b = std::string("c");
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        load< presence_bitmap_formatter< little_endian<1>, string_formatter< little_endian<1> > > >(vectorReader, std::tie(a, b));
+        EXPECT_FALSE(a);
+        EXPECT_FALSE(b);
+    }
+
+    {
+        std::vector<uint8_t> badData { 0x00, 0x02 };
+        MemoryLoadSerializer vectorReader(badData);
+        record_type loadedValue;
+        ASSERT_THROW(load<presence_format>(vectorReader, loadedValue), invalid_data);
+    }
+}
+
+TEST(HalfFloatFormatterWorks, SavingAndLoading)
+{
+    {
+        VectorSaveSerializer vectorWriter;
+        save< half_float_formatter<> >(vectorWriter, 1.0f);
+        save< half_float_formatter<> >(vectorWriter, -2.0f);
+        save< half_float_formatter<> >(vectorWriter, 65504.0f);
+        save< half_float_formatter<> >(vectorWriter, 1.0e6f);
+        save< half_float_formatter<> >(vectorWriter, std::ldexp(1.0f, -24));
+        save< half_float_formatter<> >(vectorWriter, 0.1f);
+        save< half_float_formatter<arbitrary_format_endian::order::big> >(vectorWriter, 1.0f);
+        const auto checkValue = std::vector<uint8_t> { 0x00, 0x3C, 0x00, 0xC0, 0xFF, 0x7B, 0x00, 0x7C, 0x01, 0x00, 0x66, 0x2E, 0x3C, 0x00 };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        load< const_formatter< half_float_formatter<> > >(vectorReader, 1.0f);
+        load< const_formatter< half_float_formatter<> > >(vectorReader, -2.0f);
+        load< const_formatter< half_float_formatter<> > >(vectorReader, 65504.0f);
+        float infinity;
+        load< half_float_formatter<> >(vectorReader, infinity);
+        EXPECT_TRUE(std::isinf(infinity));
+        load< const_formatter< half_float_formatter<> > >(vectorReader, std::ldexp(1.0f, -24));
+        load< const_formatter< half_float_formatter<> > >(vectorReader, 0.0999755859375f);
+        load< const_formatter< half_float_formatter<arbitrary_format_endian::order::big> > >(vectorReader, 1.0f);
+    }
+
+    {
+        // bulk conversion must give the same results as converting values one by one
+        std::vector<float> value;
+        for (int i = -500; i < 500; ++i)
+        {
+            value.push_back(i * 0.37f);
+        }
+        value.push_back(std::ldexp(1.0f, -20));
+
+        VectorSaveSerializer scalarWriter;
+        for (auto v : value)
+        {
+            save< half_float_formatter<> >(scalarWriter, v);
+        }
+
+        VectorSaveSerializer vectorWriter;
+        save< vector_formatter< little_endian<4>, half_float_formatter<> > >(vectorWriter, value);
+        ASSERT_EQ(vectorWriter.getData().size(), 4u + 2u * value.size());
+        EXPECT_TRUE(std::equal(scalarWriter.getData().begin(), scalarWriter.getData().end(), vectorWriter.getData().begin() + 4));
+
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        std::vector<float> loadedValue;
+        load< vector_formatter< little_endian<4>, half_float_formatter<> > >(vectorReader, loadedValue);
+        ASSERT_EQ(loadedValue.size(), value.size());
+        for (size_t i = 0; i < value.size(); ++i)
+        {
+            EXPECT_NEAR(loadedValue[i], value[i], std::abs(value[i]) / 1024);
+        }
+    }
+
+    {
+        std::array<float, 3> value { { 1.0f, 3.14159f, -0.5f } };
+        VectorSaveSerializer vectorWriter;
+        save< array_formatter< bfloat16_formatter<> > >(vectorWriter, value);
+        const auto checkValue = std::vector<uint8_t> { 0x80, 0x3F, 0x49, 0x40, 0x00, 0xBF };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        std::array<float, 3> loadedValue;
+        load< array_formatter< bfloat16_formatter<> > >(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue[0], 1.0f);
+        EXPECT_EQ(loadedValue[1], 3.140625f);
+        EXPECT_EQ(loadedValue[2], -0.5f);
+    }
+}
+
+TEST(QuantizedFormatterWorks, SavingAndLoading)
+{
+    using coordinate_format = quantized_formatter< 32, std::ratio<1, 10000000>, std::ratio<-180> >;
+    using reading_format = quantized_formatter< 12, std::ratio<1, 10>, std::ratio<-50>, big_endian<2> >;
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save<reading_format>(vectorWriter, 21.5);
+        save<reading_format>(vectorWriter, -50.0f);
+        save<reading_format>(vectorWriter, 359.5);
+        const auto checkValue = std::vector<uint8_t> { 0x02, 0xCB, 0x00, 0x00, 0x0F, 0xFF };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        double reading;
+        load<reading_format>(vectorReader, reading);
+        EXPECT_DOUBLE_EQ(reading, 21.5);
+        load<reading_format>(vectorReader, reading);
+        EXPECT_DOUBLE_EQ(reading, -50.0);
+        load<reading_format>(vectorReader, reading);
+        EXPECT_DOUBLE_EQ(reading, 359.5);
+    }
+
+    {
+        std::vector<double> value;
+        for (int i = 0; i < 1000; ++i)
+        {
+            value.push_back(-179.5 + i * 0.3591234567);
+        }
+
+        VectorSaveSerializer vectorWriter;
+        save< vector_formatter< little_endian<4>, coordinate_format > >(vectorWriter, value);
+        EXPECT_EQ(vectorWriter.getData().size(), 4u + 4u * value.size());
+
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        std::vector<double> loadedValue;
+        load< vector_formatter< little_endian<4>, coordinate_format > >(vectorReader, loadedValue);
+        ASSERT_EQ(loadedValue.size(), value.size());
+        for (size_t i = 0; i < value.size(); ++i)
+        {
+            EXPECT_NEAR(loadedValue[i], value[i], 0.5e-7);
+        }
+    }
+
+    {
+        VectorSaveSerializer vectorWriter;
+        ASSERT_THROW(save<reading_format>(vectorWriter, -50.1), lossy_conversion);
+        ASSERT_THROW(save<reading_format>(vectorWriter, 360.0), lossy_conversion);
+        ASSERT_THROW(save<reading_format>(vectorWriter, std::nan("")), lossy_conversion);
+
+        std::vector<float> value { 0.0f, 1.0f, 400.0f };
+        ASSERT_THROW((save< vector_formatter< little_endian<1>, reading_format > >(vectorWriter, value)), lossy_conversion);
+    }
+
+    {
+        std::vector<uint8_t> data { 0x10, 0x00 };
+        MemoryLoadSerializer vectorReader(data);
+        double reading;
+        ASSERT_THROW(load<reading_format>(vectorReader, reading), invalid_data);
+    }
+}
+
+/// @brief Arrays are quantized in bulk (vectorized, if possible) - they must give the same bytes as values quantized one by one.
+template<typename Format, typename T>
+void checkBulkQuantization(const std::vector<T>& value)
+{
+    VectorSaveSerializer bulkWriter;
+    save< vector_formatter< little_endian<4>, Format > >(bulkWriter, value);
+
+    VectorSaveSerializer vectorWriter;
+    save< little_endian<4> >(vectorWriter, value.size());
+    for (const T& element : value)
+    {
+        save<Format>(vectorWriter, element);
+    }
+
+    EXPECT_EQ(bulkWriter.getData(), vectorWriter.getData());
+}
+
+TEST(QuantizedFormatterWorks, SavingArraysInBulk)
+{
+    using reading_format = quantized_formatter< 12, std::ratio<1, 10>, std::ratio<-50>, big_endian<2> >;
+    using half_step_format = quantized_formatter< 8, std::ratio<1, 2> >;
+    using wide_format = quantized_formatter< 53, std::ratio<1> >;
+
+    std::vector<double> readings;
+    std::vector<float> floatReadings;
+    for (int i = 0; i < 4095; ++i)
+    {
+        readings.push_back(-50.0 + i * 0.1 + ((i % 3) - 1) * 0.04);
+        floatReadings.push_back(static_cast<float>(readings.back()));
+    }
+    readings.push_back(-50.05);
+    readings.push_back(359.54);
+    checkBulkQuantization<reading_format>(readings);
+    checkBulkQuantization<reading_format>(floatReadings);
+
+    // ties round to even
+    std::vector<double> halves { 0.0, 0.25, 0.75, 1.25, 1.75, 2.25, -0.25, 127.7 };
+    checkBulkQuantization<half_step_format>(halves);
+
+    std::vector<double> wide { 0.0, 1.5, 4503599627370497.0, 9007199254740991.0, 2.5 };
+    checkBulkQuantization<wide_format>(wide);
+
+    for (double outOfRange : { -0.26, 127.76, std::nan(""), -std::numeric_limits<double>::infinity() })
+    {
+        for (size_t position = 0; position < 3; ++position)
+        {
+            std::vector<double> value { 1.0, 2.0, 3.0 };
+            value[position] = outOfRange;
+            VectorSaveSerializer vectorWriter;
+            ASSERT_THROW((save< vector_formatter< little_endian<1>, half_step_format > >(vectorWriter, value)), lossy_conversion);
+        }
+    }
+}
+
+}  // namespace
@@ -11,9 +11,25 @@
 #include <arbitrary_format/formatters/vector_formatter.h>
 #include <arbitrary_format/formatters/map_formatter.h>
 #include <arbitrary_format/formatters/array_formatter.h>
+#include <arbitrary_format/formatters/collection_formatter.h>
+#include <arbitrary_format/formatters/flat_collection_loader.h>
+#include <arbitrary_format/formatters/recycling_collection_formatter.h>
+#include <arbitrary_format/utility/default_init_allocator.h>
+#include <arbitrary_format/utility/pool_allocator.h>
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
+
 namespace {
 
 using namespace arbitrary_format;
@@ -35,6 +51,14 @@ TEST(StringFormatterWorks, SavingAndLoading)
         EXPECT_EQ(vectorWriter.getData(), value);
     }
 
+    {
+        VectorSaveSerializer vectorWriter;
+        const char* string = "ala";
+        save< string_formatter< little_endian<1> > >(vectorWriter, string);
+        const auto value = std::vector<uint8_t> { 0x03, 'a', 'l', 'a' };
+        EXPECT_EQ(vectorWriter.getData(), value);
+    }
+
     {
         VectorSaveSerializer vectorWriter;
         ASSERT_THROW( save< string_formatter< little_endian<1> > >(vectorWriter,
@@ -103,6 +127,65 @@ TEST(VectorFormatterWorks, SavingAndLoading)
     }
 }
 
+TEST(VectorFormatterWorks, LoadingWithoutZeroFill)
+{
+    std::vector<uint16_t> value(10000);
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        value[i] = static_cast<uint16_t>(i * 7);
+    }
+
+    VectorSaveSerializer vectorWriter;
+    save< vector_formatter< little_endian<4>, little_endian<2> > >(vectorWriter, value);
+
+    {
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        std::vector<uint16_t> loadedValue(5, 1);
+        load< vector_formatter< little_endian<4>, little_endian<2> > >(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, value);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        std::vector< uint16_t, default_init_allocator<uint16_t> > loadedValue;
+        load< vector_formatter< little_endian<4>, little_endian<2> > >(vectorReader, loadedValue);
+        ASSERT_EQ(loadedValue.size(), value.size());
+        EXPECT_TRUE(std::equal(value.begin(), value.end(), loadedValue.begin()));
+    }
+
+    {
+        const auto data = std::vector<uint8_t> { 0x02, 0x00, 0x00, 0x00, 0x05, 0x00, 0x06, 0x00 };
+        MemoryLoadSerializer vectorReader(data);
+        auto loadedValue = value;
+        load< vector_formatter< little_endian<4>, little_endian<2> > >(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, (std::vector<uint16_t> { 5, 6 }));
+    }
+
+    {
+        const auto data = std::vector<uint8_t> { 0x05, 'h', 'e', 'l', 'l', 'o' };
+        MemoryLoadSerializer vectorReader(data);
+        std::basic_string< char, std::char_traits<char>, default_init_allocator<char> > loadedValue;
+        load< string_formatter< little_endian<1> > >(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, "hello");
+    }
+}
+
+TEST(VectorSaveSerializerWorks, OverwritingAndAppending)
+{
+    VectorSaveSerializer vectorWriter;
+    const uint8_t data[] = { 1, 2, 3, 4 };
+    vectorWriter.saveData(data, 4);
+    vectorWriter.seek(2);
+    vectorWriter.saveData(data, 4);
+    EXPECT_EQ(vectorWriter.getData(), (std::vector<uint8_t> { 1, 2, 1, 2, 3, 4 }));
+    EXPECT_EQ(vectorWriter.position(), 6u);
+
+    vectorWriter.seek(1);
+    vectorWriter.saveData(data, 2);
+    EXPECT_EQ(vectorWriter.getData(), (std::vector<uint8_t> { 1, 1, 2, 2, 3, 4 }));
+    EXPECT_EQ(vectorWriter.position(), 3u);
+}
+
 TEST(MapFormatterWorks, SavingAndLoading)
 {
     {
@@ -135,6 +218,219 @@ TEST(MapFormatterWorks, SavingAndLoading)
     }
 }
 
+TEST(CollectionFormatterWorks, SavingAndLoading)
+{
+    const auto data = std::vector<uint8_t> { 0x03, 0x01, 'c', 0x01, 'a', 0x02, 'b', 'b' };
+    using strings_format = collection_formatter< little_endian<1>, string_formatter< little_endian<1> > >;
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::vector<std::string> loadedValue { "x", "y", "z", "w" };
+        load<strings_format>(vectorReader, loadedValue);
+        const auto checkValue = std::vector<std::string> { "c", "a", "bb" };
+        EXPECT_EQ(loadedValue, checkValue);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::deque<std::string> loadedValue;
+        load<strings_format>(vectorReader, loadedValue);
+        const auto checkValue = std::deque<std::string> { "c", "a", "bb" };
+        EXPECT_EQ(loadedValue, checkValue);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::set<std::string> loadedValue { "x" };
+        load<strings_format>(vectorReader, loadedValue);
+        const auto checkValue = std::set<std::string> { "a", "bb", "c" };
+        EXPECT_EQ(loadedValue, checkValue);
+    }
+
+    {
+        using map_format = map_formatter< little_endian<1>, little_endian<1>, string_formatter< little_endian<1> > >;
+        const auto value = std::multimap< int, std::string, std::greater<int> > { {1, "a"}, {3, "c"}, {1, "b"} };
+        VectorSaveSerializer vectorWriter;
+        save<map_format>(vectorWriter, value);
+        const auto checkValue = std::vector<uint8_t> { 0x03, 3, 0x01, 'c', 1, 0x01, 'a', 1, 0x01, 'b' };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        load< const_formatter<map_format> >(vectorReader, value);
+    }
+}
+
+TEST(CollectionFormatterWorks, UnorderedAndFlatCollections)
+{
+    using map_format = map_formatter< little_endian<1>, little_endian<1>, string_formatter< little_endian<1> > >;
+    const auto data = std::vector<uint8_t> { 0x03, 3, 0x01, 'c', 1, 0x01, 'a', 2, 0x01, 'b' };
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::unordered_map<int, std::string> loadedValue { {7, "x"} };
+        load<map_format>(vectorReader, loadedValue);
+        const auto checkValue = std::unordered_map<int, std::string> { {1, "a"}, {2, "b"}, {3, "c"} };
+        EXPECT_EQ(loadedValue, checkValue);
+        EXPECT_GE(loadedValue.bucket_count() * loadedValue.max_load_factor(), 3.0f);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        boost::container::flat_map<int, std::string> loadedValue { {7, "x"} };
+        load<map_format>(vectorReader, loadedValue);
+        const auto checkValue = boost::container::flat_map<int, std::string> { {1, "a"}, {2, "b"}, {3, "c"} };
+        EXPECT_EQ(loadedValue, checkValue);
+
+        VectorSaveSerializer vectorWriter;
+        save<map_format>(vectorWriter, loadedValue);
+        const auto sortedData = std::vector<uint8_t> { 0x03, 1, 0x01, 'a', 2, 0x01, 'b', 3, 0x01, 'c' };
+        EXPECT_EQ(vectorWriter.getData(), sortedData);
+
+        MemoryLoadSerializer sortedReader(sortedData);
+        load< const_formatter<map_format> >(sortedReader, checkValue);
+    }
+
+    {
+        using set_format = collection_formatter< little_endian<1>, little_endian<2> >;
+        const auto setData = std::vector<uint8_t> { 0x04, 5, 0, 1, 0, 5, 0, 2, 0 };
+
+        MemoryLoadSerializer vectorReader(setData);
+        std::unordered_set<int> loadedValue;
+        load<set_format>(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, (std::unordered_set<int> { 1, 2, 5 }));
+
+        MemoryLoadSerializer flatReader(setData);
+        boost::container::flat_multiset<int> flatValue;
+        load<set_format>(flatReader, flatValue);
+        EXPECT_EQ(flatValue, (boost::container::flat_multiset<int> { 1, 2, 5, 5 }));
+
+        MemoryLoadSerializer badReader(setData);
+        boost::container::flat_set<int> uniqueValue;
+        ASSERT_THROW(load<set_format>(badReader, uniqueValue), invalid_data);
+    }
+}
+
+TEST(RecyclingCollectionFormatterWorks, SavingAndLoading)
+{
+    using map_format = recycling_map_formatter< little_endian<1>, little_endian<1>, string_formatter< little_endian<1> > >;
+    const auto data = std::vector<uint8_t> { 0x03, 3, 0x01, 'c', 1, 0x01, 'a', 2, 0x01, 'b' };
+    const auto checkValue = std::map<int, std::string> { {1, "a"}, {2, "b"}, {3, "c"} };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save<map_format>(vectorWriter, checkValue);
+        const auto sortedData = std::vector<uint8_t> { 0x03, 1, 0x01, 'a', 2, 0x01, 'b', 3, 0x01, 'c' };
+        EXPECT_EQ(vectorWriter.getData(), sortedData);
+    }
+
+#ifdef __cpp_lib_node_extract
+    /// @brief node extraction recycles nodes of containers with any allocator
+    {
+        std::map<int, std::string> loadedValue { {5, "x"}, {6, "y"} };
+        std::set<const std::string*> oldElements;
+        for (auto& element : loadedValue)
+        {
+            oldElements.insert(&element.second);
+        }
+
+        MemoryLoadSerializer vectorReader(data);
+        load<map_format>(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, checkValue);
+
+        size_t recycledElements = 0;
+        for (auto& element : loadedValue)
+        {
+            recycledElements += oldElements.count(&element.second);
+        }
+        EXPECT_EQ(recycledElements, 2u);
+
+        const auto shortData = std::vector<uint8_t> { 0x01, 9, 0x01, 'z' };
+        MemoryLoadSerializer shortReader(shortData);
+        load<map_format>(shortReader, loadedValue);
+        EXPECT_EQ(loadedValue, (std::map<int, std::string> { {9, "z"} }));
+    }
+#endif
+
+    /// @brief without node extraction nodes are recycled through pool_allocator's free lists
+    {
+        using pooled_map = std::map< int, std::string, std::less<int>, pool_allocator< std::pair<const int, std::string> > >;
+        node_pool pool;
+        const auto allocator = pool_allocator< std::pair<const int, std::string> >(pool);
+        pooled_map loadedValue(allocator);
+        loadedValue.emplace(5, "x");
+        loadedValue.emplace(6, "y");
+        std::set<const std::string*> oldElements;
+        for (auto& element : loadedValue)
+        {
+            oldElements.insert(&element.second);
+        }
+
+        MemoryLoadSerializer vectorReader(data);
+        load<map_format>(vectorReader, loadedValue);
+        ASSERT_EQ(loadedValue.size(), checkValue.size());
+        EXPECT_TRUE(( std::equal(loadedValue.begin(), loadedValue.end(), checkValue.begin()) ));
+
+        size_t recycledElements = 0;
+        for (auto& element : loadedValue)
+        {
+            recycledElements += oldElements.count(&element.second);
+        }
+        EXPECT_EQ(recycledElements, 2u);
+    }
+
+    /// @brief unordered containers keep their bucket array
+    {
+        using pooled_set = std::unordered_set< int, std::hash<int>, std::equal_to<int>, pool_allocator<int> >;
+        const auto setData = std::vector<uint8_t> { 0x03, 5, 0, 1, 0, 5, 0 };
+        node_pool pool;
+        pooled_set loadedValue(0, std::hash<int>(), std::equal_to<int>(), pool_allocator<int>(pool));
+        loadedValue.insert({ 7, 8, 9, 10 });
+        auto bucketCount = loadedValue.bucket_count();
+
+        MemoryLoadSerializer vectorReader(setData);
+        load< recycling_collection_formatter< little_endian<1>, little_endian<2> > >(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, (pooled_set({ 1, 5 }, 0, std::hash<int>(), std::equal_to<int>(), pool_allocator<int>(pool))));
+        EXPECT_EQ(loadedValue.bucket_count(), bucketCount);
+    }
+}
+
+#if __cplusplus >= 201703L
+
+TEST(CollectionFormatterWorks, LoadingWithPolymorphicAllocators)
+{
+    using map_format = map_formatter< little_endian<1>, string_formatter< little_endian<1> >, vector_formatter< little_endian<1>, little_endian<2> > >;
+    const auto value = std::map< std::string, std::vector<uint16_t> > { { "a rather long key, past small string optimization", { 1, 2, 3 } }, { "another rather long key, also past small strings", { 4, 5 } } };
+
+    VectorSaveSerializer vectorWriter;
+    save<map_format>(vectorWriter, value);
+
+    std::vector<uint8_t> arena(64 * 1024);
+    std::pmr::monotonic_buffer_resource resource(arena.data(), arena.size(), std::pmr::null_memory_resource());
+    std::pmr::map< std::pmr::string, std::pmr::vector<uint16_t> > loadedValue(&resource);
+    std::pmr::vector<std::pmr::string> loadedStrings(&resource);
+
+    // every allocation not coming from the arena will throw
+    auto previousResource = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    {
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        EXPECT_NO_THROW(load<map_format>(vectorReader, loadedValue));
+
+        VectorSaveSerializer keysWriter;
+        save< vector_formatter< little_endian<1>, string_formatter< little_endian<1> > > >(keysWriter, std::vector<std::string> { value.begin()->first, value.rbegin()->first });
+        MemoryLoadSerializer keysReader(keysWriter.getData());
+        EXPECT_NO_THROW((load< vector_formatter< little_endian<1>, string_formatter< little_endian<1> > > >(keysReader, loadedStrings)));
+    }
+    std::pmr::set_default_resource(previousResource);
+
+    ASSERT_EQ(loadedValue.size(), 2u);
+    EXPECT_STREQ(loadedValue.begin()->first.c_str(), value.begin()->first.c_str());
+    EXPECT_EQ(loadedValue.begin()->second, (std::pmr::vector<uint16_t> { 1, 2, 3 }));
+    ASSERT_EQ(loadedStrings.size(), 2u);
+    EXPECT_STREQ(loadedStrings[1].c_str(), value.rbegin()->first.c_str());
+}
+
+#endif
+
 TEST(FixedSizeArrayFormatterWorks, SavingAndLoading)
 {
     {
@@ -184,6 +480,29 @@ TEST(FixedSizeArrayFormatterWorks, SavingAndLoading)
     }
 }
 
+TEST(FixedSizeArrayFormatterWorks, StdArrays)
+{
+    {
+        VectorSaveSerializer vectorWriter;
+        const std::array<uint8_t, 3> value {{ 0x01, 0x02, 0x03 }};
+        save< array_formatter< little_endian<2> > >(vectorWriter, value);
+        const auto checkValue = std::vector<uint8_t> { 0x01, 0x00, 0x02, 0x00, 0x03, 0x00 };
+        EXPECT_EQ(vectorWriter.getData(), checkValue);
+
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        std::array<uint8_t, 3> loadedValue;
+        load< array_formatter< little_endian<2> > >(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, value);
+    }
+
+    {
+        std::vector<uint8_t> data { 0x01, 0x02 };
+        MemoryLoadSerializer vectorReader(data);
+        const std::array<uint8_t, 2> checkValue {{ 0x01, 0x02 }};
+        load< const_formatter< array_formatter< little_endian<1> > > >(vectorReader, checkValue);
+    }
+}
+
 TEST(FixedSizeArrayFormatterWorks, Constness)
 {
     {
@@ -0,0 +1,402 @@
+// PointerFormattersTests.cpp - tests for BinaryFormatSerializer
+//
+
+#include <arbitrary_format/serialize.h>
+#include <arbitrary_format/binary_serializers/VectorSaveSerializer.h>
+#include <arbitrary_format/binary_serializers/MemorySerializer.h>
+
+#include <arbitrary_format/binary_formatters/endian_formatter.h>
+#include <arbitrary_format/binary_formatters/varint_formatter.h>
+#include <arbitrary_format/formatters/vector_formatter.h>
+#include <arbitrary_format/formatters/polymorphic_formatter.h>
+#include <arbitrary_format/formatters/shared_ptr_copy_formatter.h>
+#include <arbitrary_format/formatters/shared_ptr_tracking_formatter.h>
+#include <arbitrary_format/utility/pool_allocator.h>
+
+#include "gtest/gtest.h"
+
+#include <memory>
+
+namespace {
+
+using namespace arbitrary_format;
+using namespace binary;
+
+template<typename T>
+struct counting_allocator
+{
+    using value_type = T;
+
+    size_t* allocations;
+
+    explicit counting_allocator(size_t* allocations)
+        : allocations(allocations)
+    {
+    }
+
+    template<typename U>
+    counting_allocator(const counting_allocator<U>& other)
+        : allocations(other.allocations)
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        ++*allocations;
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* ptr, size_t count)
+    {
+        std::allocator<T>().deallocate(ptr, count);
+    }
+
+    template<typename U>
+    bool operator==(const counting_allocator<U>& other) const
+    {
+        return allocations == other.allocations;
+    }
+
+    template<typename U>
+    bool operator!=(const counting_allocator<U>& other) const
+    {
+        return allocations != other.allocations;
+    }
+};
+
+TEST(SharedPtrCopyFormatterWorks, SavingAndLoading)
+{
+    using ptr_format = shared_ptr_copy_formatter< little_endian<1>, little_endian<2> >;
+    const auto value = std::vector< std::shared_ptr<int> > { std::make_shared<int>(0x1234), nullptr, std::make_shared<int>(5) };
+    const auto data = std::vector<uint8_t> { 0x03, 0x01, 0x34, 0x12, 0x00, 0x01, 0x05, 0x00 };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save< vector_formatter<little_endian<1>, ptr_format> >(vectorWriter, value);
+        EXPECT_EQ(vectorWriter.getData(), data);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::vector< std::shared_ptr<int> > loadedValue;
+        load< vector_formatter<little_endian<1>, ptr_format> >(vectorReader, loadedValue);
+        ASSERT_EQ(loadedValue.size(), 3u);
+        EXPECT_EQ(*loadedValue[0], 0x1234);
+        EXPECT_EQ(loadedValue[1], nullptr);
+        EXPECT_EQ(*loadedValue[2], 5);
+    }
+}
+
+TEST(SharedPtrCopyFormatterWorks, LoadingWithAllocator)
+{
+    const auto data = std::vector<uint8_t> { 0x01, 0x02, 0x07, 0x00, 0x08, 0x00 };
+    const auto checkValue = std::vector<uint16_t> { 7, 8 };
+
+    /// @brief object and control block are allocated together
+    {
+        size_t allocations = 0;
+        auto ptr_format = create_shared_ptr_copy_formatter(little_endian<1>(), vector_formatter< little_endian<1>, little_endian<2> >(), counting_allocator<char>(&allocations));
+
+        MemoryLoadSerializer vectorReader(data);
+        std::shared_ptr< std::vector<uint16_t> > loadedValue;
+        load(vectorReader, loadedValue, ptr_format);
+        ASSERT_NE(loadedValue, nullptr);
+        EXPECT_EQ(*loadedValue, checkValue);
+        EXPECT_EQ(allocations, 1u);
+    }
+
+    /// @brief object constructed after it's loaded
+    {
+        size_t allocations = 0;
+        auto ptr_format = create_shared_ptr_copy_formatter<pointee_construction::after_load>(little_endian<1>(), vector_formatter< little_endian<1>, little_endian<2> >(), counting_allocator<char>(&allocations));
+
+        MemoryLoadSerializer vectorReader(data);
+        std::shared_ptr< std::vector<uint16_t> > loadedValue;
+        load(vectorReader, loadedValue, ptr_format);
+        ASSERT_NE(loadedValue, nullptr);
+        EXPECT_EQ(*loadedValue, checkValue);
+        EXPECT_EQ(allocations, 1u);
+    }
+
+    /// @brief objects allocated from a pool
+    {
+        node_pool pool;
+        auto ptr_format = create_shared_ptr_copy_formatter(little_endian<1>(), little_endian<4>(), pool_allocator<char>(pool));
+        auto vec_format = create_vector_formatter(little_endian<2>(), ptr_format);
+
+        std::vector< std::shared_ptr<int> > value;
+        for (int i = 0; i < 1000; ++i)
+        {
+            value.push_back(i % 7 == 0 ? nullptr : std::make_shared<int>(i));
+        }
+
+        VectorSaveSerializer vectorWriter;
+        save(vectorWriter, value, vec_format);
+
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            MemoryLoadSerializer vectorReader(vectorWriter.getData());
+            std::vector< std::shared_ptr<int> > loadedValue;
+            load(vectorReader, loadedValue, vec_format);
+            ASSERT_EQ(loadedValue.size(), value.size());
+            for (size_t i = 0; i < value.size(); ++i)
+            {
+                ASSERT_EQ(loadedValue[i] == nullptr, value[i] == nullptr);
+                if (value[i])
+                {
+                    EXPECT_EQ(*loadedValue[i], *value[i]);
+                }
+            }
+        }
+    }
+}
+
+struct graph_node
+{
+    int value;
+    std::vector< std::shared_ptr<graph_node> > children;
+};
+
+struct graph_node_formatter
+{
+    shared_ptr_tracking_context& context;
+
+    template<typename TSerializer>
+    void save(TSerializer& serializer, const graph_node& node) const
+    {
+        little_endian<1>().save(serializer, node.value);
+        create_vector_formatter(little_endian<1>(), create_shared_ptr_tracking_formatter(context, varint_formatter(), *this)).save(serializer, node.children);
+    }
+
+    template<typename TSerializer>
+    void load(TSerializer& serializer, graph_node& node) const
+    {
+        little_endian<1>().load(serializer, node.value);
+        create_vector_formatter(little_endian<1>(), create_shared_ptr_tracking_formatter(context, varint_formatter(), *this)).load(serializer, node.children);
+    }
+};
+
+TEST(SharedPtrTrackingFormatterWorks, SavingAndLoading)
+{
+    const auto first = std::make_shared<int>(0x1234);
+    const auto second = std::make_shared<int>(5);
+    const auto value = std::vector< std::shared_ptr<int> > { first, second, first, nullptr, second };
+    const auto data = std::vector<uint8_t> { 0x05, 0x01, 0x34, 0x12, 0x02, 0x05, 0x00, 0x01, 0x00, 0x02 };
+
+    {
+        shared_ptr_tracking_context context;
+        VectorSaveSerializer vectorWriter;
+        save(vectorWriter, value, create_vector_formatter(little_endian<1>(), create_shared_ptr_tracking_formatter(context, little_endian<1>(), little_endian<2>())));
+        EXPECT_EQ(vectorWriter.getData(), data);
+    }
+
+    {
+        shared_ptr_tracking_context context;
+        MemoryLoadSerializer vectorReader(data);
+        std::vector< std::shared_ptr<int> > loadedValue;
+        load(vectorReader, loadedValue, create_vector_formatter(little_endian<1>(), create_shared_ptr_tracking_formatter(context, little_endian<1>(), little_endian<2>())));
+        ASSERT_EQ(loadedValue.size(), 5u);
+        EXPECT_EQ(*loadedValue[0], 0x1234);
+        EXPECT_EQ(*loadedValue[1], 5);
+        EXPECT_EQ(loadedValue[2], loadedValue[0]);
+        EXPECT_EQ(loadedValue[3], nullptr);
+        EXPECT_EQ(loadedValue[4], loadedValue[1]);
+        EXPECT_EQ(loadedValue[0].use_count(), 3);
+    }
+
+    /// @brief back-references to objects not loaded yet
+    {
+        const auto badData = std::vector<uint8_t> { 0x02, 0x01, 0x34, 0x12, 0x03, 0x05, 0x00 };
+        shared_ptr_tracking_context context;
+        MemoryLoadSerializer vectorReader(badData);
+        std::vector< std::shared_ptr<int> > loadedValue;
+        ASSERT_THROW(load(vectorReader, loadedValue, create_vector_formatter(little_endian<1>(), create_shared_ptr_tracking_formatter(context, little_endian<1>(), little_endian<2>()))), invalid_data);
+    }
+
+    /// @brief back-references to objects of a different type
+    {
+        const auto badData = std::vector<uint8_t> { 0x01, 0x34, 0x12, 0x01 };
+        shared_ptr_tracking_context context;
+        MemoryLoadSerializer vectorReader(badData);
+        auto intPtr = std::shared_ptr<int>();
+        auto shortPtr = std::shared_ptr<short>();
+        auto ptr_format = create_shared_ptr_tracking_formatter(context, little_endian<1>(), little_endian<2>());
+        load(vectorReader, intPtr, ptr_format);
+        ASSERT_THROW(load(vectorReader, shortPtr, ptr_format), invalid_data);
+    }
+
+    /// @brief saved objects are kept alive for the whole session, so a new object can't reuse the address of a saved one
+    {
+        shared_ptr_tracking_context context;
+        VectorSaveSerializer vectorWriter;
+        auto ptr_format = create_shared_ptr_tracking_formatter(context, little_endian<1>(), little_endian<2>());
+        auto temporary = std::make_shared<int>(1);
+        std::weak_ptr<int> saved = temporary;
+        save(vectorWriter, temporary, ptr_format);
+        temporary.reset();
+        EXPECT_FALSE(saved.expired());
+
+        save(vectorWriter, std::make_shared<int>(2), ptr_format);
+        const auto expected = std::vector<uint8_t> { 0x01, 0x01, 0x00, 0x02, 0x02, 0x00 };
+        EXPECT_EQ(vectorWriter.getData(), expected);
+
+        context.clear();
+        EXPECT_TRUE(saved.expired());
+    }
+}
+
+TEST(SharedPtrTrackingFormatterWorks, Cycles)
+{
+    auto root = std::make_shared<graph_node>();
+    auto leaf = std::make_shared<graph_node>();
+    root->value = 1;
+    leaf->value = 2;
+    root->children = { leaf, leaf };
+    leaf->children = { root };
+
+    VectorSaveSerializer vectorWriter;
+    {
+        shared_ptr_tracking_context context;
+        save(vectorWriter, root, create_shared_ptr_tracking_formatter(context, varint_formatter(), graph_node_formatter{ context }));
+        const auto data = std::vector<uint8_t> { 0x01, 0x01, 0x02, 0x02, 0x02, 0x01, 0x01, 0x02 };
+        EXPECT_EQ(vectorWriter.getData(), data);
+    }
+    leaf->children.clear();
+
+    {
+        shared_ptr_tracking_context context;
+        MemoryLoadSerializer vectorReader(vectorWriter.getData());
+        std::shared_ptr<graph_node> loadedRoot;
+        load(vectorReader, loadedRoot, create_shared_ptr_tracking_formatter(context, varint_formatter(), graph_node_formatter{ context }));
+        ASSERT_NE(loadedRoot, nullptr);
+        EXPECT_EQ(loadedRoot->value, 1);
+        ASSERT_EQ(loadedRoot->children.size(), 2u);
+        EXPECT_EQ(loadedRoot->children[0], loadedRoot->children[1]);
+        EXPECT_EQ(loadedRoot->children[0]->value, 2);
+        ASSERT_EQ(loadedRoot->children[0]->children.size(), 1u);
+        EXPECT_EQ(loadedRoot->children[0]->children[0], loadedRoot);
+        loadedRoot->children[0]->children.clear();
+    }
+}
+
+struct shape
+{
+    virtual ~shape() {}
+    int id = 0;
+};
+
+struct circle : public shape
+{
+    int radius = 0;
+};
+
+struct rectangle : public shape
+{
+    int width = 0;
+    int height = 0;
+};
+
+struct circle_formatter
+{
+    template<typename TSerializer>
+    void save(TSerializer& serializer, const circle& value) const
+    {
+        little_endian<1>().save(serializer, value.id);
+        little_endian<2>().save(serializer, value.radius);
+    }
+
+    template<typename TSerializer>
+    void load(TSerializer& serializer, circle& value) const
+    {
+        little_endian<1>().load(serializer, value.id);
+        little_endian<2>().load(serializer, value.radius);
+    }
+};
+
+struct rectangle_formatter
+{
+    template<typename TSerializer>
+    void save(TSerializer& serializer, const rectangle& value) const
+    {
+        little_endian<1>().save(serializer, value.id);
+        little_endian<1>().save(serializer, value.width);
+        little_endian<1>().save(serializer, value.height);
+    }
+
+    template<typename TSerializer>
+    void load(TSerializer& serializer, rectangle& value) const
+    {
+        little_endian<1>().load(serializer, value.id);
+        little_endian<1>().load(serializer, value.width);
+        little_endian<1>().load(serializer, value.height);
+    }
+};
+
+TEST(PolymorphicFormatterWorks, SavingAndLoading)
+{
+    using registry_type = polymorphic_registry<shape, VectorSaveSerializer, MemoryLoadSerializer>;
+    registry_type registry;
+    registry.register_type<circle>(1, circle_formatter());
+    registry.register_type<rectangle, rectangle_formatter>(2);
+    ASSERT_THROW(registry.register_type<rectangle>(3, rectangle_formatter()), serialization_exception);
+    ASSERT_THROW(registry.register_type<circle>(2, circle_formatter()), serialization_exception);
+
+    auto ptr_format = create_polymorphic_formatter(registry, varint_formatter());
+    const auto data = std::vector<uint8_t> { 0x03, 0x02, 0x07, 0x03, 0x04, 0x00, 0x01, 0x08, 0x34, 0x12 };
+
+    {
+        std::vector< std::unique_ptr<shape> > value;
+        std::unique_ptr<rectangle> first(new rectangle());
+        first->id = 7;
+        first->width = 3;
+        first->height = 4;
+        std::unique_ptr<circle> third(new circle());
+        third->id = 8;
+        third->radius = 0x1234;
+        value.push_back(std::move(first));
+        value.push_back(nullptr);
+        value.push_back(std::move(third));
+
+        VectorSaveSerializer vectorWriter;
+        save(vectorWriter, value, create_vector_formatter(little_endian<1>(), ptr_format));
+        EXPECT_EQ(vectorWriter.getData(), data);
+
+        ASSERT_THROW(save(vectorWriter, std::unique_ptr<shape>(new shape()), ptr_format), lossy_conversion);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::vector< std::unique_ptr<shape> > loadedValue;
+        load(vectorReader, loadedValue, create_vector_formatter(little_endian<1>(), ptr_format));
+        ASSERT_EQ(loadedValue.size(), 3u);
+        auto first = dynamic_cast<rectangle*>(loadedValue[0].get());
+        ASSERT_NE(first, nullptr);
+        EXPECT_EQ(first->id, 7);
+        EXPECT_EQ(first->width, 3);
+        EXPECT_EQ(first->height, 4);
+        EXPECT_EQ(loadedValue[1], nullptr);
+        auto third = dynamic_cast<circle*>(loadedValue[2].get());
+        ASSERT_NE(third, nullptr);
+        EXPECT_EQ(third->id, 8);
+        EXPECT_EQ(third->radius, 0x1234);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::vector< std::shared_ptr<shape> > loadedValue;
+        load(vectorReader, loadedValue, create_vector_formatter(little_endian<1>(), ptr_format));
+        ASSERT_EQ(loadedValue.size(), 3u);
+        EXPECT_NE(std::dynamic_pointer_cast<rectangle>(loadedValue[0]), nullptr);
+        EXPECT_EQ(loadedValue[1], nullptr);
+        EXPECT_NE(std::dynamic_pointer_cast<circle>(loadedValue[2]), nullptr);
+    }
+
+    {
+        const auto badData = std::vector<uint8_t> { 0x05, 0x00 };
+        MemoryLoadSerializer vectorReader(badData);
+        std::unique_ptr<shape> loadedValue;
+        ASSERT_THROW(load(vectorReader, loadedValue, ptr_format), invalid_data);
+    }
+}
+
+}  // namespace
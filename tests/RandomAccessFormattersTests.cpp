@@ -0,0 +1,408 @@
+// RandomAccessFormattersTests.cpp - tests for BinaryFormatSerializer
+//
+
+#include <arbitrary_format/serialize.h>
+#include <arbitrary_format/binary_serializers/VectorSaveSerializer.h>
+#include <arbitrary_format/binary_serializers/MemorySerializer.h>
+
+#include <arbitrary_format/binary_formatters/aligned_formatter.h>
+#include <arbitrary_format/binary_formatters/bit_formatter.h>
+#include <arbitrary_format/binary_formatters/endian_formatter.h>
+#include <arbitrary_format/binary_formatters/indexed_vector_formatter.h>
+#include <arbitrary_format/binary_formatters/lazy_formatter.h>
+#include <arbitrary_format/binary_formatters/record_view.h>
+#include <arbitrary_format/binary_formatters/size_prefix_formatter.h>
+#include <arbitrary_format/binary_formatters/string_formatter.h>
+#include <arbitrary_format/binary_formatters/varint_formatter.h>
+#include <arbitrary_format/formatters/array_formatter.h>
+#include <arbitrary_format/formatters/ensure_value.h>
+#include <arbitrary_format/formatters/map_formatter.h>
+#include <arbitrary_format/formatters/tuple_formatter.h>
+#include <arbitrary_format/formatters/vector_formatter.h>
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/range/iterator_range.hpp>
+
+namespace {
+
+using namespace arbitrary_format;
+using namespace binary;
+
+/// @brief Loading serializer that can't return views of its data.
+class copying_load_serializer
+{
+    MemoryLoadSerializer& serializer;
+
+public:
+    explicit copying_load_serializer(MemoryLoadSerializer& serializer)
+        : serializer(serializer)
+    {
+    }
+
+    using loading_serializer = std::true_type;
+
+    void loadData(uint8_t* data, size_t size)
+    {
+        serializer.loadData(data, size);
+    }
+};
+
+TEST(LazyFormatterWorks, SavingAndLoading)
+{
+    using map_format = map_formatter< little_endian<1>, little_endian<1>, string_formatter< little_endian<1> > >;
+    using lazy_format = vector_formatter< little_endian<1>, lazy_formatter<varint_formatter, map_format> >;
+    using lazy_map = lazy< std::map<int, std::string> >;
+
+    const auto value = std::vector<lazy_map> { std::map<int, std::string> { { 1, "a" } }, std::map<int, std::string> { { 2, "bc" }, { 3, "" } } };
+    const auto data = std::vector<uint8_t> { 0x02, 0x04, 0x01, 0x01, 0x01, 'a', 0x07, 0x02, 0x02, 0x02, 'b', 'c', 0x03, 0x00 };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save<lazy_format>(vectorWriter, value);
+        EXPECT_EQ(vectorWriter.getData(), data);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::vector<lazy_map> loadedValue;
+        load<lazy_format>(vectorReader, loadedValue);
+        ASSERT_EQ(loadedValue.size(), 2u);
+        EXPECT_FALSE(loadedValue[0].is_decoded());
+        EXPECT_FALSE(loadedValue[1].is_decoded());
+        EXPECT_EQ(loadedValue[1].encoded_data(), data.data() + 7);
+
+        EXPECT_EQ(loadedValue[1]->at(2), "bc");
+        EXPECT_FALSE(loadedValue[0].is_decoded());
+        EXPECT_TRUE(loadedValue[1].is_decoded());
+
+        /// @brief values that were not modified are saved without encoding
+        VectorSaveSerializer vectorWriter;
+        save<lazy_format>(vectorWriter, loadedValue);
+        EXPECT_EQ(vectorWriter.getData(), data);
+        EXPECT_FALSE(loadedValue[0].is_decoded());
+
+        (*loadedValue[0])[1] = "x";
+        EXPECT_FALSE(loadedValue[0].has_encoded());
+        VectorSaveSerializer modifiedWriter;
+        save<lazy_format>(modifiedWriter, loadedValue);
+        EXPECT_EQ(modifiedWriter.getData()[5], 'x');
+    }
+
+    /// @brief values are loaded eagerly from serializers without viewData()
+    {
+        MemoryLoadSerializer vectorReader(data);
+        copying_load_serializer copyingReader(vectorReader);
+        std::vector<lazy_map> loadedValue;
+        load<lazy_format>(copyingReader, loadedValue);
+        ASSERT_EQ(loadedValue.size(), 2u);
+        EXPECT_TRUE(loadedValue[0].is_decoded());
+        EXPECT_EQ(loadedValue[0]->at(1), "a");
+        EXPECT_EQ(loadedValue[1]->size(), 2u);
+    }
+
+    /// @brief broken data is reported on first access
+    {
+        const auto badData = std::vector<uint8_t> { 0x01, 0x05, 0x01, 0x01, 0x01, 'a', 0x00 };
+        MemoryLoadSerializer vectorReader(badData);
+        std::vector<lazy_map> loadedValue;
+        load<lazy_format>(vectorReader, loadedValue);
+        ASSERT_THROW(loadedValue[0].get(), invalid_data);
+    }
+}
+
+TEST(LazyFormatterWorks, FixedSizeValues)
+{
+    using lazy_format = vector_formatter< little_endian<1>, lazy_formatter< ensure_value<size_t>, little_endian<2> > >;
+    const auto value = std::vector< lazy<int> > { 0x1234, 0x5678 };
+    const auto data = std::vector<uint8_t> { 0x02, 0x34, 0x12, 0x78, 0x56 };
+    const auto format = lazy_format(little_endian<1>(), create_lazy_formatter(ensure_value<size_t>(2), little_endian<2>()));
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save(vectorWriter, value, format);
+        EXPECT_EQ(vectorWriter.getData(), data);
+
+        const auto badFormat = create_lazy_formatter(ensure_value<size_t>(1), little_endian<2>());
+        ASSERT_THROW(save(vectorWriter, value[0], badFormat), lossy_conversion);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::vector< lazy<int> > loadedValue;
+        load(vectorReader, loadedValue, format);
+        ASSERT_EQ(loadedValue.size(), 2u);
+        EXPECT_FALSE(loadedValue[1].is_decoded());
+        EXPECT_EQ(*loadedValue[1], 0x5678);
+        EXPECT_EQ(*loadedValue[0], 0x1234);
+    }
+}
+
+TEST(IndexedVectorFormatterWorks, SavingAndLoading)
+{
+    using indexed_format = indexed_vector_formatter< little_endian<1>, little_endian<2>, string_formatter< little_endian<1> > >;
+    using delta_format = indexed_vector_formatter< little_endian<1>, varint_formatter, string_formatter< little_endian<1> >, offset_encoding::delta >;
+    const auto value = std::vector<std::string> { "ab", "", "cde" };
+    const auto data = std::vector<uint8_t> { 0x03, 0x03, 0x00, 0x04, 0x00, 0x08, 0x00, 0x02, 'a', 'b', 0x00, 0x03, 'c', 'd', 'e', 0x07 };
+    const auto deltaData = std::vector<uint8_t> { 0x03, 0x03, 0x01, 0x04, 0x02, 'a', 'b', 0x00, 0x03, 'c', 'd', 'e', 0x07 };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save<indexed_format>(vectorWriter, value);
+        save< little_endian<1> >(vectorWriter, 7);
+        EXPECT_EQ(vectorWriter.getData(), data);
+
+        VectorSaveSerializer deltaWriter;
+        save<delta_format>(deltaWriter, value);
+        save< little_endian<1> >(deltaWriter, 7);
+        EXPECT_EQ(deltaWriter.getData(), deltaData);
+
+        VectorSaveSerializer factoryWriter;
+        save(factoryWriter, value, create_indexed_vector_formatter<offset_encoding::delta>(little_endian<1>(), varint_formatter(), string_formatter< little_endian<1> >()));
+        save< little_endian<1> >(factoryWriter, 7);
+        EXPECT_EQ(factoryWriter.getData(), deltaData);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::vector<std::string> loadedValue;
+        load<indexed_format>(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, value);
+
+        MemoryLoadSerializer deltaReader(deltaData);
+        std::vector<std::string> loadedDeltaValue;
+        load<delta_format>(deltaReader, loadedDeltaValue);
+        EXPECT_EQ(loadedDeltaValue, value);
+    }
+
+    /// @brief random access leaves the serializer after the vector
+    {
+        MemoryLoadSerializer vectorReader(data);
+        auto reader = indexed_format().open(vectorReader);
+        EXPECT_EQ(vectorReader.position(), data.size() - 1);
+        ASSERT_EQ(reader.size(), 3u);
+        EXPECT_EQ(reader.get<std::string>(2), "cde");
+        EXPECT_EQ(reader.element_size(1), 1u);
+        EXPECT_EQ(reader.get<std::string>(0), "ab");
+        ASSERT_THROW(reader.get<std::string>(3), serialization_exception);
+
+        int next = 0;
+        load< little_endian<1> >(vectorReader, next);
+        EXPECT_EQ(next, 7);
+
+        MemoryLoadSerializer deltaReader(deltaData);
+        auto deltaVectorReader = delta_format().open(deltaReader);
+        EXPECT_EQ(deltaVectorReader.get<std::string>(2), "cde");
+        EXPECT_EQ(deltaVectorReader.get<std::string>(1), "");
+        EXPECT_EQ(deltaReader.position(), deltaData.size() - 1);
+    }
+
+    {
+        const auto badData = std::vector<uint8_t> { 0x02, 0x04, 0x00, 0x03, 0x00, 0x02, 'a', 'b', 0x00 };
+        MemoryLoadSerializer vectorReader(badData);
+        std::vector<std::string> loadedValue;
+        ASSERT_THROW(load<indexed_format>(vectorReader, loadedValue), invalid_data);
+
+        MemoryLoadSerializer randomReader(badData);
+        auto reader = indexed_format().open(randomReader);
+        ASSERT_THROW(reader.get<std::string>(1), invalid_data);
+    }
+}
+
+using point_format = tuple_formatter< big_endian<2>, little_endian<1> >;
+using record_format = tuple_formatter< big_endian<4>, little_endian<2>, bit_formatter<arbitrary_format_endian::order::little, 3, 5>, array_formatter<little_endian<1>, 3>, point_format >;
+using record = std::tuple< uint32_t, int16_t, std::tuple<unsigned, unsigned>, const uint8_t*, std::tuple<int, int> >;
+
+static_assert(fixed_size_of<record_format>::value == 13, "Record of fixed size formatters should have fixed size.");
+static_assert(field_offset<record_format, 3>::value == 7, "Field offset should be the sum of sizes of preceding fields.");
+
+TEST(RecordViewWorks, ReadingFields)
+{
+    const uint8_t firstArray[] = { 1, 2, 3 };
+    const uint8_t secondArray[] = { 4, 5, 6 };
+    const auto value = std::vector<record> {
+        record { 0x01020304, -2, std::make_tuple(5u, 17u), firstArray, std::make_tuple(0x1234, 9) },
+        record { 7, 0x1122, std::make_tuple(0u, 31u), secondArray, std::make_tuple(1, 2) },
+    };
+    const auto data = std::vector<uint8_t> {
+        0x02,
+        0x01, 0x02, 0x03, 0x04, 0xFE, 0xFF, 0x8D, 0x01, 0x02, 0x03, 0x12, 0x34, 0x09,
+        0x00, 0x00, 0x00, 0x07, 0x22, 0x11, 0xF8, 0x04, 0x05, 0x06, 0x00, 0x01, 0x02,
+    };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save< vector_formatter<little_endian<1>, record_format> >(vectorWriter, value);
+        EXPECT_EQ(vectorWriter.getData(), data);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        size_t count;
+        load< little_endian<1> >(vectorReader, count);
+        auto records = load_record_array_view<record_format>(vectorReader, count);
+        EXPECT_EQ(vectorReader.position(), data.size());
+        ASSERT_EQ(records.size(), 2u);
+
+        EXPECT_EQ((records[0].get<0, uint32_t>()), 0x01020304u);
+        EXPECT_EQ((records[0].get<1, int>()), -2);
+        EXPECT_EQ((records[1].get<1, int>()), 0x1122);
+        EXPECT_TRUE((records[0].get< 2, std::tuple<unsigned, unsigned> >() == std::make_tuple(5u, 17u)));
+        uint8_t loadedArray[3];
+        records[1].load<3>(loadedArray);
+        EXPECT_TRUE(std::equal(loadedArray, loadedArray + 3, secondArray));
+        EXPECT_EQ((records[0].view<4>().get<0, int>()), 0x1234);
+        EXPECT_EQ((records[1].view<4>().get<1, int>()), 2);
+
+        MemoryLoadSerializer recordReader(data.data() + 1, record_view<record_format>::size);
+        auto view = load_record_view<record_format>(recordReader);
+        EXPECT_EQ(view.get_data(), data.data() + 1);
+        ASSERT_THROW(load_record_view<record_format>(recordReader), end_of_input);
+
+        ASSERT_THROW((record_array_view<record_format>(data.data(), data.size())), invalid_data);
+    }
+}
+
+TEST(RecordViewWorks, PatchingFields)
+{
+    const uint8_t arrayValue[] = { 1, 2, 3 };
+    const auto value = record { 0x01020304, -2, std::make_tuple(5u, 17u), arrayValue, std::make_tuple(0x1234, 9) };
+    const auto data = std::vector<uint8_t> { 0x01, 0x02, 0x03, 0x04, 0xFE, 0xFF, 0x8D, 0x01, 0x02, 0x03, 0x12, 0x34, 0x09 };
+
+    {
+        auto patchedData = data;
+        mutable_record_view<record_format> view(patchedData.data());
+        view.set<1>(0x1122);
+        view.view<4>().set<0>(0x7BCD);
+        EXPECT_EQ((view.get<1, int>()), 0x1122);
+        EXPECT_EQ((view.view<4>().get<0, int>()), 0x7BCD);
+        EXPECT_EQ(patchedData[4], 0x22);
+        EXPECT_EQ(patchedData[10], 0x7B);
+
+        auto beforeFailedPatch = patchedData;
+        ASSERT_THROW(view.set<1>(0x10000), lossy_conversion);
+        ASSERT_THROW(view.set<2>(std::make_tuple(8u, 0u)), lossy_conversion);
+        EXPECT_EQ(patchedData, beforeFailedPatch);
+    }
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save< little_endian<1> >(vectorWriter, 7);
+        save<record_format>(vectorWriter, value);
+        save< little_endian<1> >(vectorWriter, 8);
+
+        patch_field<record_format, 0>(vectorWriter, 1, 0x0A0B0C0Du);
+        patch_field<record_format, 3>(vectorWriter, 1, "xyz");
+        EXPECT_EQ(vectorWriter.position(), data.size() + 2);
+        ASSERT_THROW((patch_field<record_format, 1>(vectorWriter, 1, 0x10000)), lossy_conversion);
+
+        auto patchedData = data;
+        patchedData[0] = 0x0A;
+        patchedData[1] = 0x0B;
+        patchedData[2] = 0x0C;
+        patchedData[3] = 0x0D;
+        patchedData[7] = 'x';
+        patchedData[8] = 'y';
+        patchedData[9] = 'z';
+        patchedData.insert(patchedData.begin(), 7);
+        patchedData.push_back(8);
+        EXPECT_EQ(vectorWriter.getData(), patchedData);
+    }
+}
+
+TEST(AlignedFormatterWorks, SavingAndLoading)
+{
+    using aligned_vector_format = vector_formatter< aligned_formatter< 4, little_endian<4> >, little_endian<4> >;
+    const auto value = std::vector<uint32_t> { 0x01020304, 0x05060708 };
+    const auto data = std::vector<uint8_t> { 0x07, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x04, 0x03, 0x02, 0x01, 0x08, 0x07, 0x06, 0x05 };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save< little_endian<1> >(vectorWriter, 7);
+        save<aligned_vector_format>(vectorWriter, value);
+        EXPECT_EQ(vectorWriter.getData(), data);
+
+        VectorSaveSerializer rangeWriter;
+        save< little_endian<1> >(rangeWriter, 7);
+        save<aligned_vector_format>(rangeWriter, boost::make_iterator_range(value.data(), value.data() + value.size()));
+        EXPECT_EQ(rangeWriter.getData(), data);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        int first;
+        std::vector<uint32_t> loadedValue;
+        load< little_endian<1> >(vectorReader, first);
+        load<aligned_vector_format>(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, value);
+    }
+
+    /// @brief verbatim elements are viewed in place
+    {
+        MemoryLoadSerializer vectorReader(data);
+        int first;
+        boost::iterator_range<const uint32_t*> loadedRange;
+        load< little_endian<1> >(vectorReader, first);
+        load<aligned_vector_format>(vectorReader, loadedRange);
+        EXPECT_EQ(reinterpret_cast<const uint8_t*>(loadedRange.begin()), data.data() + 8);
+        EXPECT_EQ(std::vector<uint32_t>(loadedRange.begin(), loadedRange.end()), value);
+    }
+
+    {
+        auto badPadding = data;
+        badPadding[2] = 1;
+        MemoryLoadSerializer vectorReader(badPadding);
+        int first;
+        std::vector<uint32_t> loadedValue;
+        load< little_endian<1> >(vectorReader, first);
+        ASSERT_THROW(load<aligned_vector_format>(vectorReader, loadedValue), invalid_data);
+
+        /// @brief alignment is relative to the serializer, so elements of unaligned formats are rejected
+        const auto unalignedData = std::vector<uint8_t> { 0x01, 0x04, 0x03, 0x02, 0x01 };
+        MemoryLoadSerializer unalignedReader(unalignedData);
+        boost::iterator_range<const uint32_t*> loadedRange;
+        ASSERT_THROW((load< vector_formatter< little_endian<1>, little_endian<4> > >(unalignedReader, loadedRange)), invalid_data);
+    }
+}
+
+TEST(AlignedFormatterWorks, AligningElementsInSizePrefixedRecords)
+{
+    using aligned_size_format = aligned_formatter< 8, little_endian<4>, padding_placement::after_value >;
+    using record_format = size_prefix_formatter< little_endian<4>, vector_formatter< aligned_size_format, little_endian<8> > >;
+    const auto value = std::vector<double> { 1.5, -2.25, 1e100 };
+
+    VectorSaveSerializer vectorWriter;
+    save< little_endian<1> >(vectorWriter, 7);
+    save<record_format>(vectorWriter, value);
+    const auto& data = vectorWriter.getData();
+    ASSERT_EQ(data.size(), 1u + 4 + 4 + 7 + 3 * 8);
+    EXPECT_TRUE(( std::all_of(data.begin() + 9, data.begin() + 16, [](uint8_t byte) { return byte == 0; }) ));
+
+    /// @brief elements, not the size, start at a multiple of 8, even though the size has 4 bytes
+    {
+        MemoryLoadSerializer vectorReader(data);
+        int first;
+        boost::iterator_range<const double*> loadedRange;
+        load< little_endian<1> >(vectorReader, first);
+        load<record_format>(vectorReader, loadedRange);
+        EXPECT_EQ(reinterpret_cast<const uint8_t*>(loadedRange.begin()), data.data() + 16);
+        EXPECT_EQ(std::vector<double>(loadedRange.begin(), loadedRange.end()), value);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        int first;
+        std::vector<double> loadedValue;
+        load< little_endian<1> >(vectorReader, first);
+        load<record_format>(vectorReader, loadedValue);
+        EXPECT_EQ(loadedValue, value);
+    }
+}
+
+}  // namespace
@@ -0,0 +1,196 @@
+// TypeErasedFormattersTests.cpp - tests for BinaryFormatSerializer
+//
+
+#include <arbitrary_format/serialize.h>
+#include <arbitrary_format/binary_serializers/VectorSaveSerializer.h>
+#include <arbitrary_format/binary_serializers/MemorySerializer.h>
+
+#include <arbitrary_format/binary_formatters/endian_formatter.h>
+#include <arbitrary_format/binary_formatters/string_formatter.h>
+#include <arbitrary_format/formatters/any_formatter.h>
+#include <arbitrary_format/formatters/map_formatter.h>
+#include <arbitrary_format/formatters/type_formatter.h>
+#include <arbitrary_format/formatters/variant_formatter.h>
+#include <arbitrary_format/formatters/vector_formatter.h>
+#include <arbitrary_format/utility/small_buffer_storage.h>
+
+#include "gtest/gtest.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/any.hpp>
+#include <boost/variant.hpp>
+
+#if __cplusplus >= 201703L
+#include <variant>
+#endif
+
+namespace {
+
+using namespace arbitrary_format;
+using namespace binary;
+
+struct big_formatter : public little_endian<2>
+{
+    char padding[256];
+};
+
+TEST(SmallBufferStorageWorks, CopyingAndMoving)
+{
+    small_buffer_storage<> small(std::string("a rather long string, that is past small string optimization"));
+    small_buffer_storage<> big(std::vector<int>(100, 7));
+    auto counter = std::make_shared<int>(0);
+
+    {
+        small_buffer_storage<> copy(small);
+        EXPECT_EQ(copy.get<std::string>(), small.get<std::string>());
+        EXPECT_NE(copy.get<std::string>().data(), small.get<std::string>().data());
+
+        small_buffer_storage<> moved(std::move(copy));
+        EXPECT_TRUE(copy.empty());
+        EXPECT_EQ(moved.get<std::string>(), small.get<std::string>());
+
+        moved = big;
+        EXPECT_EQ(moved.get< std::vector<int> >(), big.get< std::vector<int> >());
+
+        moved.emplace< std::shared_ptr<int> >(counter);
+        EXPECT_EQ(counter.use_count(), 2);
+        moved = small_buffer_storage<>();
+        EXPECT_EQ(counter.use_count(), 1);
+
+        small_buffer_storage<8> heap(counter);
+        small_buffer_storage<8> heapCopy(heap);
+        EXPECT_EQ(counter.use_count(), 3);
+        small_buffer_storage<8> heapMoved(std::move(heapCopy));
+        EXPECT_EQ(counter.use_count(), 3);
+    }
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(TypeFormatterWorks, SavingAndLoading)
+{
+    using map_format = map_formatter< little_endian<1>, little_endian<1>, string_formatter< little_endian<1> > >;
+    const auto value = std::map<int, std::string> { { 1, "a" }, { 2, "bc" } };
+    const auto data = std::vector<uint8_t> { 0x02, 0x01, 0x01, 'a', 0x02, 0x02, 'b', 'c' };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        auto format = make_type_formatter< VectorSaveSerializer, std::map<int, std::string> >(map_format());
+        auto formatCopy = format;
+        save(vectorWriter, value, formatCopy);
+        EXPECT_EQ(vectorWriter.getData(), data);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::map<int, std::string> loadedValue;
+        auto format = make_type_formatter< MemoryLoadSerializer, std::map<int, std::string> >(map_format());
+        load(vectorReader, loadedValue, format);
+        EXPECT_EQ(loadedValue, value);
+    }
+
+    /// @brief formatters that don't fit in the small buffer
+    {
+        VectorSaveSerializer vectorWriter;
+        std::vector< type_formatter<VectorSaveSerializer, int> > formats;
+        formats.emplace_back(little_endian<1>());
+        formats.emplace_back(big_formatter());
+        for (auto& format : formats)
+        {
+            save(vectorWriter, 0x1234 & 0xFF, format);
+        }
+        const auto checkData = std::vector<uint8_t> { 0x34, 0x34, 0x00 };
+        EXPECT_EQ(vectorWriter.getData(), checkData);
+    }
+}
+
+TEST(AnyFormatterWorks, SavingAndLoading)
+{
+    const auto data = std::vector<uint8_t> { 0x34, 0x12, 0x78, 0x56 };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        auto format = make_any_formatter<VectorSaveSerializer, int>(little_endian<2>());
+        save(vectorWriter, 0x1234, format);
+        save(vectorWriter, boost::any(0x5678), format);
+        EXPECT_EQ(vectorWriter.getData(), data);
+
+        ASSERT_THROW(save(vectorWriter, short(5), format), boost::bad_any_cast);
+        ASSERT_THROW(save(vectorWriter, boost::any(short(5)), format), boost::bad_any_cast);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        auto format = make_any_formatter<MemoryLoadSerializer, int>(little_endian<2>());
+        int loadedValue = 0;
+        load(vectorReader, loadedValue, format);
+        EXPECT_EQ(loadedValue, 0x1234);
+
+        boost::any loadedAny = 0;
+        load(vectorReader, loadedAny, format);
+        EXPECT_EQ(boost::any_cast<int>(loadedAny), 0x5678);
+
+        short wrongValue;
+        ASSERT_THROW(load(vectorReader, wrongValue, format), boost::bad_any_cast);
+    }
+}
+
+TEST(VariantFormatterWorks, SavingAndLoading)
+{
+    using value_variant = boost::variant< int, std::string, std::vector<uint16_t> >;
+    using variant_format = variant_formatter< little_endian<1>, little_endian<2>, string_formatter< little_endian<1> >, vector_formatter< little_endian<1>, little_endian<2> > >;
+    const auto value = std::vector<value_variant> { 0x1234, std::string("ab"), std::vector<uint16_t> { 5, 6 }, 7 };
+    const auto data = std::vector<uint8_t> { 0x04, 0x00, 0x34, 0x12, 0x01, 0x02, 'a', 'b', 0x02, 0x02, 0x05, 0x00, 0x06, 0x00, 0x00, 0x07, 0x00 };
+
+    {
+        VectorSaveSerializer vectorWriter;
+        save< vector_formatter<little_endian<1>, variant_format> >(vectorWriter, value);
+        EXPECT_EQ(vectorWriter.getData(), data);
+    }
+
+    {
+        MemoryLoadSerializer vectorReader(data);
+        std::vector<value_variant> loadedValue;
+        load< vector_formatter<little_endian<1>, variant_format> >(vectorReader, loadedValue);
+        EXPECT_TRUE(loadedValue == value);
+    }
+
+    /// @brief active alternative is loaded in place
+    {
+        const auto stringData = std::vector<uint8_t> { 0x01, 0x02, 'c', 'd' };
+        MemoryLoadSerializer vectorReader(stringData);
+        value_variant loadedValue = std::string(100, 'x');
+        const char* storage = boost::get<std::string>(loadedValue).data();
+        load<variant_format>(vectorReader, loadedValue);
+        EXPECT_EQ(boost::get<std::string>(loadedValue), "cd");
+        EXPECT_EQ(boost::get<std::string>(loadedValue).data(), storage);
+    }
+
+    {
+        const auto badData = std::vector<uint8_t> { 0x03, 0x00, 0x00 };
+        MemoryLoadSerializer vectorReader(badData);
+        value_variant loadedValue;
+        ASSERT_THROW(load<variant_format>(vectorReader, loadedValue), invalid_data);
+    }
+
+#if __cplusplus >= 201703L
+    {
+        using std_variant = std::variant< int, std::string, std::vector<uint16_t> >;
+        const auto stdValue = std::vector<std_variant> { 0x1234, std::string("ab"), std::vector<uint16_t> { 5, 6 }, 7 };
+
+        VectorSaveSerializer vectorWriter;
+        save< vector_formatter<little_endian<1>, variant_format> >(vectorWriter, stdValue);
+        EXPECT_EQ(vectorWriter.getData(), data);
+
+        MemoryLoadSerializer vectorReader(data);
+        std::vector<std_variant> loadedValue;
+        load< vector_formatter<little_endian<1>, variant_format> >(vectorReader, loadedValue);
+        EXPECT_TRUE(loadedValue == stdValue);
+    }
+#endif
+}
+
+}  // namespace
@@ -5,16 +5,24 @@
 #include <arbitrary_format/serialization_exceptions.h>
 #include <arbitrary_format/binary_serializers/VectorSaveSerializer.h>
 #include <arbitrary_format/binary_serializers/MemorySerializer.h>
+#include <arbitrary_format/binary_serializers/BackpatchingSerializer.h>
+#include <arbitrary_format/binary_serializers/HeadroomSaveSerializer.h>
+#include <arbitrary_format/binary_serializers/LimitedSerializer.h>
+#include <arbitrary_format/binary_serializers/ReverseSaveSerializer.h>
 
 #include <arbitrary_format/binary_formatters/endian_formatter.h>
+#include <arbitrary_format/binary_formatters/string_formatter.h>
+#include <arbitrary_format/binary_formatters/varint_formatter.h>
 #include <arbitrary_format/formatters/const_formatter.h>
 #include <arbitrary_format/binary_formatters/size_prefix_formatter.h>
 #include <arbitrary_format/formatters/vector_formatter.h>
+#include <arbitrary_format/formatters/tuple_formatter.h>
 #include <arbitrary_format/formatters/array_formatter.h>
 #include <arbitrary_format/formatters/external_value.h>
 #include <arbitrary_format/formatters/serialize_buffer.h>
 #include <arbitrary_format/binary_formatters/verbatim_formatter.h>
 
+#include <limits>
 #include <type_traits>
 
 #include "gtest/gtest.h"
@@ -24,13 +32,13 @@ struct fake_verbatim
     template<typename T, typename TSerializer>
     void save(TSerializer& serializer, const T& value) const
     {
-        BOOST_THROW_EXCEPTION(serialization_exception());
+        BOOST_THROW_EXCEPTION(arbitrary_format::serialization_exception());
     }
 
     template<typename T, typename TSerializer>
     void load(TSerializer& serializer, T& value) const
     {
-        BOOST_THROW_EXCEPTION(serialization_exception());
+        BOOST_THROW_EXCEPTION(arbitrary_format::serialization_exception());
     }
 };
 
@@ -50,6 +58,20 @@ namespace {
 
 using namespace arbitrary_format;
 using namespace binary;
+
+/// @brief Saving serializer without position() and seek().
+class forward_only_serializer
+{
+public:
+    std::vector<uint8_t> data;
+
+    using saving_serializer = std::true_type;
+
+    void saveData(const uint8_t* bytes, size_t size)
+    {
+        data.insert(data.end(), bytes, bytes + size);
+    }
+};
     
 TEST(SerializeBufferWorks, SavingAndLoading)
 {
@@ -177,6 +199,16 @@ TEST(SizePrefixFormatterWorks, SavingAndLoading)
         ASSERT_TRUE(( std::equal(value.begin(), value.end(), vectorWriter.getData()) ));
     }
 
+    /// @brief data saved after a size prefixed value goes after the value, not over it
+    {
+        VectorSaveSerializer vectorWriter;
+        save< size_prefix_formatter< little_endian<1>, little_endian<2> > >(vectorWriter, 0x1234);
+        EXPECT_EQ(vectorWriter.position(), 3u);
+        save< little_endian<1> >(vectorWriter, 0x56);
+        const auto value = std::vector<uint8_t> { 0x02, 0x34, 0x12, 0x56 };
+        EXPECT_EQ(vectorWriter.getData(), value);
+    }
+
     {
         uint8_t data[] = { 0x04, 0x00, 0x00, 0x00, 0x78, 0x56, 0x34, 0x12 };
         MemoryLoadSerializer arrayReader(data, sizeof(data));
@@ -193,6 +225,224 @@ TEST(SizePrefixFormatterWorks, SavingAndLoading)
     }
 }
 
+/// @brief Saves one byte more every time it's used.
+class growing_formatter
+{
+    mutable uint8_t byteCount = 0;
+
+public:
+    template<typename ValueType, typename TSerializer>
+    void save(TSerializer& serializer, const ValueType&) const
+    {
+        ++byteCount;
+        for (uint8_t i = 0; i < byteCount; ++i)
+        {
+            little_endian<1>().save(serializer, i);
+        }
+    }
+};
+
+TEST(PrependingSerializersWork, SavingAndPrepending)
+{
+    /// @brief nested size prefixes saved back to front, last field first
+    {
+        using inner_format = size_prefix_formatter< varint_formatter, tuple_formatter< little_endian<4>, string_formatter< little_endian<1> > > >;
+        using outer_format = size_prefix_formatter< little_endian<1>, tuple_formatter< inner_format, little_endian<2> > >;
+
+        ReverseSaveSerializer reverseWriter(4);
+        auto outerEnd = reverseWriter.position();
+        prepend_value< little_endian<2> >(reverseWriter, 0x5678);
+        auto innerEnd = reverseWriter.position();
+        prepend_value(reverseWriter, std::string("xy"), string_formatter< little_endian<1> >());
+        prepend_value< little_endian<4> >(reverseWriter, 0x01020304);
+        prepend_size_prefix<varint_formatter>(reverseWriter, reverseWriter.position() - innerEnd);
+        prepend_size_prefix< little_endian<1> >(reverseWriter, reverseWriter.position() - outerEnd);
+        prepend_value(reverseWriter, std::string("hdr"), string_formatter< little_endian<1> >());
+
+        VectorSaveSerializer vectorWriter;
+        save< string_formatter< little_endian<1> > >(vectorWriter, std::string("hdr"));
+        save<outer_format>(vectorWriter, std::make_tuple(std::make_tuple(0x01020304, std::string("xy")), 0x5678));
+        EXPECT_EQ(reverseWriter.getDataVector(), vectorWriter.getData());
+        EXPECT_EQ(reverseWriter.position(), vectorWriter.getData().size());
+
+        const auto data = reverseWriter.getDataVector();
+        MemoryLoadSerializer arrayReader(data);
+        std::string header;
+        std::tuple<std::tuple<int, std::string>, int> value;
+        load< string_formatter< little_endian<1> > >(arrayReader, header);
+        load<outer_format>(arrayReader, value);
+        EXPECT_EQ(header, "hdr");
+        EXPECT_EQ(std::get<0>(std::get<0>(value)), 0x01020304);
+        EXPECT_EQ(std::get<1>(std::get<0>(value)), "xy");
+        EXPECT_EQ(std::get<1>(value), 0x5678);
+        EXPECT_EQ(arrayReader.position(), data.size());
+    }
+
+    /// @brief a value that fails to format leaves the data unchanged
+    {
+        ReverseSaveSerializer reverseWriter(4);
+        prepend_value< little_endian<2> >(reverseWriter, 0x5678);
+        ASSERT_THROW(prepend_value(reverseWriter, 0, growing_formatter()), serialization_exception);
+        EXPECT_EQ(reverseWriter.getDataVector(), (std::vector<uint8_t> { 0x78, 0x56 }));
+    }
+
+    /// @brief ReverseSaveSerializer isn't a saving serializer, so formatters that call saveData() more than once can't silently reverse their data
+    {
+        static_assert(!is_saving_serializer<ReverseSaveSerializer>::value, "ReverseSaveSerializer must not be a saving serializer.");
+    }
+
+    /// @brief envelope prepended to a payload saved front to back
+    {
+        using payload_format = size_prefix_formatter< little_endian<1>, string_formatter< little_endian<1> > >;
+
+        HeadroomSaveSerializer headroomWriter(2);
+        save<payload_format>(headroomWriter, std::string("abc"));
+        const uint8_t* payload = headroomWriter.getData();
+        prepend_size_prefix< little_endian<2> >(headroomWriter, headroomWriter.getDataSize());
+        EXPECT_EQ(headroomWriter.getData() + 2, payload);
+        EXPECT_EQ(headroomWriter.getHeadroom(), 0u);
+
+        prepend_value< big_endian<1> >(headroomWriter, 7);
+        save< little_endian<1> >(headroomWriter, 8);
+        EXPECT_EQ(headroomWriter.position(), headroomWriter.getDataSize());
+
+        const auto data = headroomWriter.getDataVector();
+        MemoryLoadSerializer arrayReader(data);
+        int header;
+        std::string value;
+        int trailer;
+        load< big_endian<1> >(arrayReader, header);
+        load< size_prefix_formatter< little_endian<2>, payload_format > >(arrayReader, value);
+        load< little_endian<1> >(arrayReader, trailer);
+        EXPECT_EQ(header, 7);
+        EXPECT_EQ(value, "abc");
+        EXPECT_EQ(trailer, 8);
+        EXPECT_EQ(arrayReader.position(), data.size());
+    }
+}
+
+TEST(BackpatchingSerializerWorks, SavingSizePrefixes)
+{
+    using inner_format = size_prefix_formatter< little_endian<1>, string_formatter< little_endian<1> > >;
+    using outer_format = size_prefix_formatter< little_endian<2>, inner_format >;
+    const auto data = std::vector<uint8_t> { 0x07, 0x05, 0x00, 0x04, 0x03, 'a', 'b', 'c', 0x08 };
+
+    forward_only_serializer sink;
+    BackpatchingSerializer<forward_only_serializer> writer(sink);
+
+    save< little_endian<1> >(writer, 7);
+    EXPECT_EQ(sink.data.size(), 1u);
+    EXPECT_EQ(writer.getHeldSize(), 0u);
+
+    save<outer_format>(writer, std::string("abc"));
+    EXPECT_EQ(writer.position(), 8u);
+    EXPECT_EQ(writer.getHeldSize(), 0u);
+
+    save< little_endian<1> >(writer, 8);
+    EXPECT_EQ(sink.data, data);
+
+    ASSERT_THROW(writer.seek(1), serialization_exception);
+    ASSERT_THROW(writer.releaseOutput(), serialization_exception);
+
+    /// @brief nothing is sent before the outermost hold is released
+    writer.holdOutput();
+    save<outer_format>(writer, std::string("x"));
+    EXPECT_EQ(sink.data.size(), data.size());
+    EXPECT_EQ(writer.getHeldSize(), 5u);
+    writer.releaseOutput();
+    EXPECT_EQ(sink.data.size(), data.size() + 5);
+
+    /// @brief failed save drops its partial data, and doesn't leave the output held
+    const auto tooLong = std::string(300, 'x');
+    ASSERT_THROW(save<outer_format>(writer, tooLong), lossy_conversion);
+    EXPECT_EQ(writer.getHeldSize(), 0u);
+    EXPECT_EQ(writer.position(), data.size() + 5);
+
+    save<outer_format>(writer, std::string("y"));
+    EXPECT_EQ(writer.getHeldSize(), 0u);
+    const auto expected = std::vector<uint8_t> { 0x03, 0x00, 0x02, 0x01, 'y' };
+    EXPECT_TRUE(( std::equal(expected.begin(), expected.end(), sink.data.end() - expected.size()) ));
+    EXPECT_EQ(sink.data.size(), data.size() + 10);
+
+    ASSERT_THROW(writer.abortOutput(), serialization_exception);
+}
+
+TEST(LimitedSerializerWorks, LoadingNestedSizePrefixes)
+{
+    using inner_format = size_prefix_formatter< little_endian<1>, string_formatter< little_endian<1> > >;
+    using middle_format = size_prefix_formatter< little_endian<1>, inner_format >;
+    using outer_format = size_prefix_formatter< little_endian<2>, middle_format >;
+
+    {
+        std::array<uint8_t, 8> data;
+        MemorySaveSerializer arrayWriter(data);
+        save<outer_format>(arrayWriter, std::string("abc"));
+        const auto value = std::vector<uint8_t> { 0x06, 0x00, 0x05, 0x04, 0x03, 'a', 'b', 'c' };
+        ASSERT_TRUE(( std::equal(value.begin(), value.end(), arrayWriter.getData()) ));
+    }
+
+    {
+        uint8_t data[] = { 0x06, 0x00, 0x05, 0x04, 0x03, 'a', 'b', 'c' };
+        MemoryLoadSerializer arrayReader(data, sizeof(data));
+        std::string value;
+        load<outer_format>(arrayReader, value);
+        EXPECT_EQ(value, "abc");
+    }
+
+    /// @brief inner size exceeds outer size
+    {
+        uint8_t data[] = { 0x06, 0x00, 0x05, 0x07, 0x03, 'a', 'b', 'c', 0x00, 0x00 };
+        MemoryLoadSerializer arrayReader(data, sizeof(data));
+        std::string value;
+        ASSERT_THROW(load<outer_format>(arrayReader, value), end_of_input);
+    }
+
+    /// @brief innermost value doesn't consume all its data
+    {
+        uint8_t data[] = { 0x06, 0x00, 0x05, 0x04, 0x02, 'a', 'b', 'c' };
+        MemoryLoadSerializer arrayReader(data, sizeof(data));
+        std::string value;
+        ASSERT_THROW(load<outer_format>(arrayReader, value), invalid_data);
+    }
+
+    /// @brief limits nest on one serializer
+    {
+        uint8_t data[] = { 0x01, 0x02, 0x03, 0x04 };
+        MemoryLoadSerializer arrayReader(data, sizeof(data));
+        LimitedSerializer<MemoryLoadSerializer> limitedReader(arrayReader);
+        uintmax_t unlimited = limitedReader.pushLimit(3);
+        uintmax_t outerLimit = limitedReader.pushLimit(2);
+        EXPECT_EQ(limitedReader.getBytesLeft(), 2u);
+        ASSERT_THROW(limitedReader.pushLimit(3), end_of_input);
+        int value;
+        load< little_endian<1> >(limitedReader, value);
+        ASSERT_THROW(limitedReader.popLimit(outerLimit), invalid_data);
+        ASSERT_THROW(load< little_endian<2> >(limitedReader, value), end_of_input);
+        load< little_endian<1> >(limitedReader, value);
+        limitedReader.popLimit(outerLimit);
+        EXPECT_EQ(limitedReader.getBytesLeft(), 1u);
+        load< little_endian<1> >(limitedReader, value);
+        EXPECT_EQ(value, 0x03);
+        limitedReader.popLimit(unlimited);
+        EXPECT_EQ(limitedReader.getBytesLeft(), std::numeric_limits<uintmax_t>::max() - 3);
+    }
+
+    /// @brief a failed nested load doesn't leave its limit behind
+    {
+        uint8_t data[] = { 0x01, 0x02, 0x03, 0x04 };
+        MemoryLoadSerializer arrayReader(data, sizeof(data));
+        LimitedSerializer<MemoryLoadSerializer> limitedReader(arrayReader);
+        limitedReader.pushLimit(4);
+        int value;
+        ASSERT_THROW(load_limited(limitedReader, 2, little_endian<4>(), value), end_of_input);
+        EXPECT_EQ(limitedReader.getBytesLeft(), 4u);
+        ASSERT_THROW(load_limited(limitedReader, 2, little_endian<1>(), value), invalid_data);
+        EXPECT_EQ(limitedReader.getBytesLeft(), 3u);
+        load< little_endian<3> >(limitedReader, value);
+        EXPECT_EQ(value, 0x040302);
+    }
+}
+
 TEST(ExternalValueWorks, SavingAndLoading)
 {
     {